@@ -13,10 +13,59 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
 
+#pragma once
+
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace ThermoHubClient
 {
+/// Properties returned for each substance by aql_thermofun_database_from_thermodataset (name, AQL expression)
+const std::vector<std::pair<std::string, std::string>> aql_substance_fields = {
+    {"name", "s.properties.name"},
+    {"symbol", "s.properties.symbol"},
+    {"formula", "s.properties.formula"},
+    {"formula_charge", "s.properties.formula_charge"},
+    {"reaction", "reactions_[0].symbol"},
+    {"mass_per_mole", "{values : [s.properties.mass_per_mole] }"},
+    {"aggregate_state", "s.properties.aggregate_state"},
+    {"class_", "s.properties.class_"},
+    {"limitsTP", "s.properties.limitsTP"},
+    {"Tst", "s.properties.Tst"},
+    {"Pst", "s.properties.Pst"},
+    {"TPMethods", "s.properties.TPMethods"},
+    {"sm_heat_capacity_p", "s.properties.sm_heat_capacity_p"},
+    {"sm_gibbs_energy", "s.properties.sm_gibbs_energy"},
+    {"sm_enthalpy", "s.properties.sm_enthalpy"},
+    {"sm_entropy_abs", "s.properties.sm_entropy_abs"},
+    {"sm_volume", "s.properties.sm_volume"},
+    {"m_compressibility", "s.properties.m_compressibility"},
+    {"m_expansivity", "s.properties.m_expansivity"},
+    {"datasources", "s.properties.datasources"}};
+
+/// Properties returned for each reaction by aql_thermofun_database_from_thermodataset (name, AQL expression)
+const std::vector<std::pair<std::string, std::string>> aql_reaction_fields = {
+    {"symbol", "r.properties.symbol"},
+    {"equation", "r.properties.equation"},
+    {"reactants", "reactants_"},
+    {"limitsTP", "r.properties.limitsTP"},
+    {"Tst", "r.properties.Tst"},
+    {"Pst", "r.properties.Pst"},
+    {"TPMethods", "r.properties.TPMethods"},
+    {"logKr", "r.properties.logKr"},
+    {"drsm_heat_capacity_p", "r.properties.drsm_heat_capacity_p"},
+    {"drsm_gibbs_energy", "r.properties.drsm_gibbs_energy"},
+    {"drsm_enthalpy", "r.properties.drsm_enthalpy"},
+    {"drsm_entropy", "r.properties.drsm_entropy"},
+    {"drsm_volume", "r.properties.drsm_volume"},
+    {"datasources", "r.properties.datasources"}};
+
+/// Symbols of all reactions defining a substance, queried only for the complete ThermoDataSets held in memory,
+/// whose local subsets then select the same reactions as the server query (the reaction property is the first one)
+const std::pair<std::string, std::string> aql_defining_reactions_field = {"defining_reactions", "reactions_[*].symbol"};
+
+// %substance_fields% and %reaction_fields% are replaced by the returned properties
 const std::string aql_thermofun_database_from_thermodataset =   
 "/* clean the result with vs code \n "
 "replace ^.*null.*,$\n with empty \n "
@@ -35,104 +84,46 @@ const std::string aql_thermofun_database_from_thermodataset =
 "LET elements_ = ( \n "
 "   FOR v,e IN 1..1 INBOUND @idThermoDataSet basis \n "
 "        FILTER v._label == 'element' \n "
-"        LET references_ = ( \n "
-"            FOR rf IN 1..1 OUTBOUND v citing \n "
-"            RETURN rf.properties.shortname // substances_[*][*].id \n "
-"        )  \n "
 "        RETURN { \n "
 "            symbol: v.properties.symbol, \n "
 "            class_:   v.properties.class_, \n "
 "            entropy : v.properties.entropy, \n "
 "            atomic_mass : v.properties.atomic_mass, \n "
 "            datasources : v.properties.datasources \n "
-"//            _label : 'element' \n "
 "        } \n "
 ") \n "
-"/* Get Substances */ \n "
-"LET substances_ = ( \n "
+"/* Get Substances with the Reactions defining them, in one traversal of pulls */ \n "
+"LET records_ = ( \n "
 "   FOR s,e IN 1..1 INBOUND @idThermoDataSet pulls \n "
 "        FILTER s._label == 'substance' \n "
 "        FILTER s.properties.symbol IN @symbolList \n"
 "        FILTER s.properties.class_ IN @class_List \n"
 "        FILTER s.properties.aggregate_state IN @aggregate_stateList \n"
-"        LET reaction_symbol = ( \n "
+"        LET reactions_ = ( \n "
 "            FOR r IN 1..1 INBOUND s defines \n "
-"            RETURN r.properties.symbol \n "
-"        ) \n "
-"        LET references_ = ( \n "
-"            FOR rf IN 1..1 OUTBOUND s citing \n "
-"            RETURN rf.properties.shortname // substances_[*][*].id \n "
+"            LET reactants_ = ( \n "
+"                FOR ss, t IN 1..1 INBOUND r takes \n "
+"                RETURN { \n "
+"                    symbol: ss.properties.symbol, \n "
+"                    coefficient: t.properties.stoi_coeff \n "
+"                } \n "
+"            ) \n "
+"            RETURN { %reaction_fields% } \n "
 "        ) \n "
-"        RETURN { \n " 
-"            name:   s.properties.name, \n "
-"            symbol: s.properties.symbol, \n "
-"            formula:    s.properties.formula, \n "
-"            formula_charge: s.properties.formula_charge, \n "
-"            reaction : reaction_symbol[0], \n "
-"            mass_per_mole:  {values : [s.properties.mass_per_mole] }, \n "
-"            aggregate_state:    s.properties.aggregate_state, \n "
-"            class_:    s.properties.class_, \n "
-"            limitsTP:   s.properties.limitsTP, \n "
-"            Tst:    s.properties.Tst, \n "
-"            Pst:    s.properties.Pst, \n "
-"            TPMethods:  s.properties.TPMethods, \n "
-"            sm_heat_capacity_p: s.properties.sm_heat_capacity_p, \n "
-"            sm_gibbs_energy:    s.properties.sm_gibbs_energy, \n "
-"            sm_enthalpy:    s.properties.sm_enthalpy, \n "
-"            sm_entropy_abs: s.properties.sm_entropy_abs, \n "
-"            sm_volume:  s.properties.sm_volume, \n "
-"            m_compressibility: s.properties.m_compressibility, \n "
-"            m_expansivity: s.properties.m_expansivity, \n "
-"            datasources : s.properties.datasources \n "
-"//            _label : 'substance' \n "
-"//            id: s._id \n "
-"        } \n "
+"        RETURN { substance : { %substance_fields% }, reactions : reactions_ } \n "
 ") \n "
-"/* Get Reactions */ \n "
-"LET reactions_ = ( \n "
-"   FOR s,e IN 1..1 INBOUND @idThermoDataSet pulls \n "
-"        FILTER s._label == 'substance' \n "
-"        FILTER s.properties.symbol IN @symbolList \n"
-"        FILTER s.properties.class_ IN @class_List \n"
-"        FILTER s.properties.aggregate_state IN @aggregate_stateList \n"
-"        FOR r IN 1..1 INBOUND s defines \n "
-"        LET reactants_ = ( \n "
-"            FOR ss, t IN 1..1 INBOUND r takes \n "
-"/*            LET ids_2 = PUSH(ids_, ss._id, true) /* add substance id to idlist */ \n "
-"            RETURN { \n "
-"                symbol: ss.properties.symbol, \n "
-"                coefficient: t.properties.stoi_coeff \n "
-"//                id: ss._id \n "
-"            } \n "
-"        ) \n "
-"        LET references_ = ( \n "
-"            FOR rf IN 1..1 OUTBOUND r citing \n "
-"            RETURN rf.properties.shortname // substances_[*][*].id \n "
-"        ) \n "
-"        RETURN { \n "
-"//            name:   r.properties.name, \n "
-"            symbol: r.properties.symbol, \n "
-"//            substance : s.properties.symbol, \n "
-"            equation:    r.properties.equation, \n "
-"            reactants: reactants_, \n "
-"            limitsTP:   r.properties.limitsTP, \n "
-"            Tst:    r.properties.Tst, \n "
-"            Pst:    r.properties.Pst, \n "
-"            TPMethods:  r.properties.TPMethods, \n "
-"            logKr : r.properties.logKr, \n "
-"            drsm_heat_capacity_p : r.properties.drsm_heat_capacity_p, \n "
-"            drsm_gibbs_energy : r.properties.drsm_gibbs_energy, \n "
-"            drsm_enthalpy : r.properties.drsm_enthalpy, \n "
-"            drsm_entropy : r.properties.drsm_entropy, \n "
-"            drsm_volume : r.properties.drsm_volume, \n "
-"            datasources : r.properties.datasources \n "
-"//            _label : 'reaction' \n "
-"//            id: r._id \n "
-"        } \n "
+"/* Records are unique by symbol, and sorted by symbol; the records with the same symbol are equal, \n "
+"   AGGREGATE keeps one of them without collecting the groups */ \n "
+"LET unique_substances_ = ( \n "
+"   FOR x IN records_ COLLECT symbol = x.substance.symbol AGGREGATE record = MIN(x.substance) RETURN record \n "
+") \n "
+"LET unique_reactions_ = ( \n "
+"   FOR x IN FLATTEN(records_[*].reactions) COLLECT symbol = x.symbol AGGREGATE record = MIN(x) RETURN record \n "
+") \n "
+"LET unique_elements_ = ( \n "
+"   FOR x IN elements_ COLLECT symbol = x.symbol AGGREGATE record = MIN(x) RETURN record \n "
 ") \n "
-"//LET data_ = (APPEND(SORTED_UNIQUE(FLATTEN(substances_,1)), SORTED_UNIQUE(FLATTEN(reactions_,1)), true) ) \n "
-"//RETURN {result : APPEND(data_, SORTED_UNIQUE(FLATTEN(elements_,1)), true) } \n "
 "RETURN { thermodataset : tds, datasources : ['db.thermohub.org'], date : DATE_FORMAT(DATE_NOW(), '%dd.%mm.%yyyy %hh:%ii:%ss'),  \n "
-"          substances : SORTED_UNIQUE(FLATTEN(substances_,1)), reactions : SORTED_UNIQUE(FLATTEN(reactions_,1)), elements : SORTED_UNIQUE(FLATTEN(elements_,1))} \n ";
+"          substances : unique_substances_, reactions : unique_reactions_, elements : unique_elements_ } \n ";
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,546 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#include "CacheDaemon.h"
+#include "DatabaseClient.h"
+#include "ThermoDataSetIndex.h"
+#include "common/SingleFlight.h"
+
+// C++ includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace ThermoHubClient
+{
+
+#if defined(_WIN32)
+
+auto requestFromCacheDaemon(const std::string &, const CacheDaemonRequest &) -> DatabaseResult
+{
+    throw std::runtime_error("ThermoHubClient: the cache daemon is not available on Windows");
+}
+
+struct CacheDaemon::Impl
+{
+};
+
+CacheDaemon::CacheDaemon(const std::string &, const std::string &, const CacheDaemonOptions &)
+{
+    throw std::runtime_error("ThermoHubClient: the cache daemon is not available on Windows");
+}
+
+CacheDaemon::~CacheDaemon()
+{
+}
+
+auto CacheDaemon::run() -> void
+{
+}
+
+auto CacheDaemon::stop() -> void
+{
+}
+
+auto CacheDaemon::reload() -> void
+{
+}
+
+#else
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace
+{
+
+// longest request line accepted by the daemon
+const std::size_t max_request_size = 1 << 20;
+
+auto systemError(const std::string &what) -> std::runtime_error
+{
+    return std::runtime_error("ThermoHubClient cache daemon: " + what + ": " + std::strerror(errno));
+}
+
+// closes a file descriptor when going out of scope
+struct FileDescriptor
+{
+    int fd;
+
+    explicit FileDescriptor(int fd_) : fd(fd_) {}
+
+    ~FileDescriptor()
+    {
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+};
+
+auto socketAddress(const std::string &socketPath) -> sockaddr_un
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("ThermoHubClient cache daemon: socket path too long " + socketPath);
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+auto sendAll(int socket, const char *data, std::size_t size) -> void
+{
+    while (size > 0)
+    {
+        auto sent = ::send(socket, data, size, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw systemError("send");
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+}
+
+// send a line, with a file descriptor attached if fd >= 0
+auto sendLine(int socket, const std::string &line, int fd) -> void
+{
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    iovec iov;
+    iov.iov_base = const_cast<char *>(line.data());
+    iov.iov_len = line.size();
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+
+    union
+    {
+        char buffer[CMSG_SPACE(sizeof(int))];
+        cmsghdr align;
+    } control;
+    std::memset(&control, 0, sizeof(control));
+    if (fd >= 0)
+    {
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+        auto cmsg = CMSG_FIRSTHDR(&message);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    ssize_t sent;
+    do
+        sent = ::sendmsg(socket, &message, MSG_NOSIGNAL);
+    while (sent < 0 && errno == EINTR);
+    if (sent < 0)
+        throw systemError("sendmsg");
+    if (static_cast<std::size_t>(sent) < line.size())
+        sendAll(socket, line.data() + sent, line.size() - static_cast<std::size_t>(sent));
+}
+
+// receive a line, and the file descriptor attached to it if any
+auto receiveLine(int socket, int &fd) -> std::string
+{
+    fd = -1;
+    std::string line;
+    char buffer[4096];
+    while (line.find('\n') == std::string::npos)
+    {
+        if (line.size() > max_request_size)
+            throw std::runtime_error("ThermoHubClient cache daemon: message too long");
+
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        iovec iov;
+        iov.iov_base = buffer;
+        iov.iov_len = sizeof(buffer);
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        union
+        {
+            char buffer[CMSG_SPACE(sizeof(int))];
+            cmsghdr align;
+        } control;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+
+        auto received = ::recvmsg(socket, &message, 0);
+        if (received < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw systemError("recvmsg");
+        }
+        if (received == 0)
+            throw std::runtime_error("ThermoHubClient cache daemon: connection closed");
+
+        for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg))
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && fd < 0)
+                std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+        line.append(buffer, static_cast<std::size_t>(received));
+    }
+    return line.substr(0, line.find('\n'));
+}
+
+// anonymous shared memory object holding data
+auto sharedMemoryWith(const std::string &data) -> int
+{
+    static std::atomic<unsigned> counter{0};
+    auto name = "/thermohubclient-" + std::to_string(::getpid()) + "-" + std::to_string(counter++);
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        throw systemError("shm_open");
+    // only the file descriptors keep the object alive
+    ::shm_unlink(name.c_str());
+    FileDescriptor object(fd);
+
+    if (!data.empty())
+    {
+        if (::ftruncate(fd, static_cast<off_t>(data.size())) != 0)
+            throw systemError("ftruncate");
+        auto memory = ::mmap(nullptr, data.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (memory == MAP_FAILED)
+            throw systemError("mmap");
+        std::memcpy(memory, data.data(), data.size());
+        ::munmap(memory, data.size());
+    }
+    object.fd = -1;
+    return fd;
+}
+
+// map the shared memory object into a result, the mapping is released with the last copy of the result
+auto readSharedMemory(int fd, std::size_t size) -> DatabaseResult
+{
+    if (size == 0)
+        return DatabaseResult();
+    auto memory = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+        throw systemError("mmap");
+    std::shared_ptr<const void> mapping(memory, [size](const void *address) { ::munmap(const_cast<void *>(address), size); });
+    return DatabaseResult(static_cast<const char *>(memory), size, std::move(mapping));
+}
+
+// limit the time send and recv wait for the other side of a connection
+auto setTimeout(int socket, int seconds) -> void
+{
+    if (seconds <= 0)
+        return;
+    timeval timeout;
+    timeout.tv_sec = seconds;
+    timeout.tv_usec = 0;
+    ::setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+// keep only the selected properties (and the symbol) of the substances and reactions
+auto removeUnselectedProperties(json &thermodataset, const std::vector<std::string> &properties) -> void
+{
+    if (properties.empty())
+        return;
+    std::set<std::string> selected(properties.begin(), properties.end());
+    selected.insert("symbol");
+    for (const auto &name : {"substances", "reactions"})
+    {
+        auto records = thermodataset.find(name);
+        if (records == thermodataset.end())
+            continue;
+        for (auto &record : *records)
+            for (auto it = record.begin(); it != record.end();)
+                it = selected.count(it.key()) ? std::next(it) : record.erase(it);
+    }
+}
+
+} // namespace
+
+auto requestFromCacheDaemon(const std::string &socketPath, const CacheDaemonRequest &request) -> DatabaseResult
+{
+    FileDescriptor socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+    if (socket.fd < 0)
+        throw systemError("socket");
+    auto address = socketAddress(socketPath);
+    if (::connect(socket.fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        throw systemError("connect to " + socketPath);
+
+    json jrequest = {{"thermodataset", request.thermodataset},
+                     {"elements", request.elements},
+                     {"substances", request.substances},
+                     {"classesOfSubstance", request.classesOfSubstance},
+                     {"aggregateStates", request.aggregateStates},
+                     {"selectedProperties", request.selectedProperties},
+                     {"filterCharge", request.filterCharge},
+                     {"jsonIndent", request.jsonIndent}};
+    auto line = jrequest.dump() + "\n";
+    sendAll(socket.fd, line.data(), line.size());
+
+    int fd = -1;
+    auto response = json::parse(receiveLine(socket.fd, fd));
+    FileDescriptor result(fd);
+    auto error = response.find("error");
+    if (error != response.end())
+        throw std::runtime_error("ThermoHubClient cache daemon: " + error->get<std::string>());
+    if (result.fd < 0)
+        throw std::runtime_error("ThermoHubClient cache daemon: no result received");
+    return readSharedMemory(result.fd, response.at("size").get<std::size_t>());
+}
+
+struct CacheDaemon::Impl
+{
+    std::string socketPath;
+
+    std::string configuration;
+
+    CacheDaemonOptions options;
+
+    int listening = -1;
+
+    std::atomic<bool> stopping{false};
+
+    // set by reload(), the held ThermoDataSets are dropped by the next request
+    std::atomic<bool> reloading{false};
+
+    // complete ThermoDataSet and the time it was downloaded
+    struct HeldThermoDataSet
+    {
+        std::shared_ptr<const ThermoDataSetIndex> index;
+        std::chrono::steady_clock::time_point fetched;
+    };
+
+    // complete ThermoDataSets by symbol
+    std::map<std::string, HeldThermoDataSet> thermodatasets;
+
+    std::mutex thermodatasetsMutex;
+
+    // concurrent requests for a ThermoDataSet not yet held download it once
+    SingleFlight<std::shared_ptr<const ThermoDataSetIndex>> downloads;
+
+    // accepted connections waiting for a worker, at most one per worker
+    std::deque<int> connections;
+
+    std::mutex connectionsMutex;
+
+    std::condition_variable connectionsChanged;
+
+    auto thermoDataSet(const std::string &symbol) -> std::shared_ptr<const ThermoDataSetIndex>
+    {
+        {
+            std::lock_guard<std::mutex> lock(thermodatasetsMutex);
+            if (reloading.exchange(false))
+                thermodatasets.clear();
+            auto itr = thermodatasets.find(symbol);
+            if (itr != thermodatasets.end() &&
+                (options.timeToLiveSeconds <= 0 ||
+                 std::chrono::steady_clock::now() - itr->second.fetched < std::chrono::seconds(options.timeToLiveSeconds)))
+                return itr->second.index;
+        }
+        auto index = downloads.run(symbol, [&]() {
+            std::unique_ptr<DatabaseClient> client(configuration.empty() ? new DatabaseClient() : new DatabaseClient(configuration));
+            return client->getThermoDataSetIndex(symbol);
+        });
+        std::lock_guard<std::mutex> lock(thermodatasetsMutex);
+        auto &held = thermodatasets[symbol];
+        if (held.index != index)
+            held = {index, std::chrono::steady_clock::now()};
+        return index;
+    }
+
+    // serve the accepted connections until the daemon stops
+    auto work() -> void
+    {
+        while (true)
+        {
+            int connection;
+            {
+                std::unique_lock<std::mutex> lock(connectionsMutex);
+                connectionsChanged.wait(lock, [this]() { return stopping || !connections.empty(); });
+                if (connections.empty())
+                    return;
+                connection = connections.front();
+                connections.pop_front();
+            }
+            connectionsChanged.notify_all();
+            FileDescriptor closing(connection);
+            if (!stopping)
+                serve(connection);
+        }
+    }
+
+    auto serve(int connection) -> void
+    {
+        try
+        {
+            int none = -1;
+            auto request = json::parse(receiveLine(connection, none));
+            if (none >= 0)
+                ::close(none);
+            auto list = [&request](const char *name) {
+                return request.value(name, std::vector<std::string>{});
+            };
+            auto subset = thermoDataSet(request.at("thermodataset").get<std::string>())
+                              ->subset(list("elements"), list("substances"), list("classesOfSubstance"),
+                                       list("aggregateStates"), request.value("filterCharge", false));
+            removeUnselectedProperties(subset, list("selectedProperties"));
+            auto text = subset.dump(request.value("jsonIndent", -1));
+
+            FileDescriptor shared(sharedMemoryWith(text));
+            sendLine(connection, json{{"size", text.size()}}.dump() + "\n", shared.fd);
+        }
+        catch (std::exception &e)
+        {
+            try
+            {
+                sendLine(connection, json{{"error", e.what()}}.dump() + "\n", -1);
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+};
+
+CacheDaemon::CacheDaemon(const std::string &socketPath, const std::string &connection_configuration,
+                         const CacheDaemonOptions &options)
+    : pimpl(new Impl())
+{
+    pimpl->socketPath = socketPath;
+    pimpl->configuration = connection_configuration;
+    pimpl->options = options;
+
+    auto address = socketAddress(socketPath);
+    pimpl->listening = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (pimpl->listening < 0)
+        throw systemError("socket");
+    ::unlink(socketPath.c_str());
+    if (::bind(pimpl->listening, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::listen(pimpl->listening, SOMAXCONN) != 0)
+    {
+        auto error = systemError("listen on " + socketPath);
+        ::close(pimpl->listening);
+        throw error;
+    }
+}
+
+CacheDaemon::~CacheDaemon()
+{
+    stop();
+    ::close(pimpl->listening);
+    ::unlink(pimpl->socketPath.c_str());
+}
+
+auto CacheDaemon::run() -> void
+{
+    auto workers = static_cast<std::size_t>(std::max(pimpl->options.workers, 0));
+    if (workers == 0)
+        workers = std::max<std::size_t>(2, std::thread::hardware_concurrency());
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < workers; ++i)
+        threads.emplace_back([this]() { pimpl->work(); });
+
+    // the workers finish the connections they are serving and close the waiting ones
+    auto joinWorkers = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(pimpl->connectionsMutex);
+            pimpl->stopping = true;
+        }
+        pimpl->connectionsChanged.notify_all();
+        for (auto &thread : threads)
+            thread.join();
+    };
+
+    try
+    {
+        while (!pimpl->stopping)
+        {
+            // accept only when a worker can take the connection, the others wait in the socket backlog
+            {
+                std::unique_lock<std::mutex> lock(pimpl->connectionsMutex);
+                if (!pimpl->connectionsChanged.wait_for(lock, std::chrono::milliseconds(200), [&]() {
+                        return pimpl->stopping || pimpl->connections.size() < workers;
+                    }))
+                    continue;
+            }
+
+            pollfd listening = {pimpl->listening, POLLIN, 0};
+            auto ready = ::poll(&listening, 1, 200);
+            if (ready < 0 && errno != EINTR)
+                throw systemError("poll");
+            if (ready <= 0)
+                continue;
+
+            int connection = ::accept(pimpl->listening, nullptr, nullptr);
+            if (connection < 0)
+                continue;
+            setTimeout(connection, pimpl->options.connectionTimeoutSeconds);
+
+            {
+                std::lock_guard<std::mutex> lock(pimpl->connectionsMutex);
+                pimpl->connections.push_back(connection);
+            }
+            pimpl->connectionsChanged.notify_all();
+        }
+    }
+    catch (...)
+    {
+        joinWorkers();
+        throw;
+    }
+    joinWorkers();
+}
+
+auto CacheDaemon::stop() -> void
+{
+    pimpl->stopping = true;
+}
+
+auto CacheDaemon::reload() -> void
+{
+    pimpl->reloading = true;
+}
+
+#endif
+
+} // namespace ThermoHubClient
@@ -0,0 +1,101 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "DatabaseResult.h"
+
+// C++ includes
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ThermoHubClient
+{
+
+/// Request of a ThermoDataSet subset to the cache daemon
+struct CacheDaemonRequest
+{
+    std::string thermodataset;
+    std::vector<std::string> elements;
+    std::vector<std::string> substances;
+    std::vector<std::string> classesOfSubstance;
+    std::vector<std::string> aggregateStates;
+    // properties of the substances and reactions to return (all if empty)
+    std::vector<std::string> selectedProperties;
+    bool filterCharge = false;
+    int jsonIndent = -1;
+};
+
+/**
+ * @brief Get a ThermoDataSet subset from the cache daemon of this node.
+ * The request is sent over the Unix domain socket of the daemon, the result is handed
+ * over in a shared memory object.
+ *
+ * @param socketPath path of the Unix domain socket the daemon listens on
+ * @param request selection of the ThermoDataSet subset
+ * @return DatabaseResult ThermoDataSet subset JSON string, viewing the shared memory mapping
+ * without a copy (the mapping is released with the last copy of the result)
+ */
+auto requestFromCacheDaemon(const std::string &socketPath, const CacheDaemonRequest &request) -> DatabaseResult;
+
+/// Settings of the cache daemon
+struct CacheDaemonOptions
+{
+    /// threads serving the connections, 0 for the hardware threads (at least 2); further
+    /// connections wait in the socket backlog until a thread is free
+    int workers = 0;
+
+    /// seconds a downloaded ThermoDataSet is served before it is downloaded again, 0 to keep it
+    int timeToLiveSeconds = 0;
+
+    /// seconds a connection may wait for a client to send its request or take its answer
+    int connectionTimeoutSeconds = 30;
+};
+
+/// Cache daemon serving ThermoDataSet subsets to the processes of a node. Each complete
+/// ThermoDataSet is downloaded once and held in memory (until its time to live is over or
+/// reload() is called), subsets are selected locally. Only available on POSIX systems.
+class CacheDaemon
+{
+public:
+    /**
+     * @param socketPath path of the Unix domain socket to listen on (replaced if it exists)
+     * @param connection_configuration ThermoHub connection configuration file, default connection if empty
+     * @param options worker threads, time to live of the ThermoDataSets and connection timeout
+     */
+    CacheDaemon(const std::string &socketPath, const std::string &connection_configuration = "",
+                const CacheDaemonOptions &options = CacheDaemonOptions());
+
+    /// Stops serving and removes the socket
+    ~CacheDaemon();
+
+    /// Serve requests until stop() is called
+    auto run() -> void;
+
+    /// Make run() return (can be called from another thread or a signal handler)
+    auto stop() -> void;
+
+    /// Drop the ThermoDataSets held, the next requests download them again
+    /// (can be called from another thread or a signal handler)
+    auto reload() -> void;
+
+private:
+    struct Impl;
+
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace ThermoHubClient
@@ -0,0 +1,32 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "CsrMatrix.h"
+
+namespace ThermoHubClient
+{
+
+auto CsrMatrix::dense(std::size_t cols) const -> std::vector<double>
+{
+    const auto rows = rowOffsets.empty() ? 0 : rowOffsets.size() - 1;
+    std::vector<double> matrix(rows * cols, 0.);
+    for (std::size_t i = 0; i < rows; ++i)
+        for (auto k = rowOffsets[i]; k < rowOffsets[i + 1]; ++k)
+            matrix[i * cols + columns[k]] = values[k];
+    return matrix;
+}
+
+} // namespace ThermoHubClient
@@ -0,0 +1,40 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+// C++ includes
+#include <cstddef>
+#include <vector>
+
+namespace ThermoHubClient
+{
+
+/// Matrix of doubles in compressed sparse row format, the entries of row i are rowOffsets[i] to rowOffsets[i + 1]
+struct CsrMatrix
+{
+    /// start of the entries of each row, with the end of the last one (rows + 1 values)
+    std::vector<std::size_t> rowOffsets;
+    /// column of each entry
+    std::vector<std::size_t> columns;
+    /// value of each entry
+    std::vector<double> values;
+
+    /// The row-major dense matrix with cols columns
+    auto dense(std::size_t cols) const -> std::vector<double>;
+};
+
+} // namespace ThermoHubClient
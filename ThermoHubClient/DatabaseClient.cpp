@@ -15,13 +15,32 @@
 
 #include "DatabaseClient.h"
 #include "AqlQueries.h"
-#include "formulaparser/FormulaParser.h"
+#include "CacheDaemon.h"
+#include "QueryExecutor.h"
+#include "ElementFilter.h"
+#include "ThermoDataSetIndex.h"
+#include "common/Arena.h"
+#include "common/JsonView.h"
+#include "common/VelocyPackView.h"
+#include "common/MemoryUsage.h"
+#include "common/SingleFlight.h"
+#include "common/ThreadPool.h"
 
 // C++ includes
-#include <regex>
-#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <set>
 #include <sstream>
 #include <limits>
+#include <thread>
+#include <vector>
 
 // jsonarango
 #include "jsonarango/arangocollection.h"
@@ -38,6 +57,93 @@ const arangocpp::ArangoDBConnection default_data(arangocpp::ArangoDBConnection::
                                                  "funrem",                                              
                                                  "ThermoFun@Remote-ThermoHub-Server",                   
                                                  "hub_main");                                           
+// records parsed, or bytes written, between two progress reports
+const std::size_t progressRecords = 1024;
+const std::size_t progressBytes = 1 << 20;
+
+// cancellation and progress of a get, save or columns request
+struct RequestMonitor
+{
+    std::shared_ptr<const CancellationToken> cancellation;
+
+    ProgressCallback callback;
+
+    RequestProgress progress;
+
+    auto token() const -> const CancellationToken * { return cancellation.get(); }
+
+    auto cancelled() const -> bool { return cancellation && cancellation->isCancelled(); }
+
+    // throw CancelledError if the request was cancelled, otherwise report its progress at the stage
+    auto report(RequestStage stage) -> void
+    {
+        if (cancellation)
+            cancellation->throwIfCancelled();
+        progress.stage = stage;
+        if (callback)
+            callback(progress);
+    }
+};
+
+// stream buffer collecting the output in chunks forwarded to another buffer, reporting the bytes written
+// to the request monitor, whose CancelledError aborts the output (with std::ios::badbit in the stream exceptions)
+class ProgressStreamBuffer : public std::streambuf
+{
+public:
+    ProgressStreamBuffer(std::streambuf *target_, RequestMonitor &monitor_)
+        : target(target_), monitor(monitor_), buffer(progressBytes / 16)
+    {
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+
+protected:
+    auto overflow(int_type ch) -> int_type override
+    {
+        if (!forward())
+            return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    auto sync() -> int override
+    {
+        return forward() ? 0 : -1;
+    }
+
+private:
+    std::streambuf *target;
+    RequestMonitor &monitor;
+    std::vector<char> buffer;
+    std::size_t nextReport = progressBytes;
+
+    // pass the collected output to the target buffer
+    auto forward() -> bool
+    {
+        auto size = static_cast<std::streamsize>(pptr() - pbase());
+        if (size > 0 && target->sputn(pbase(), size) != size)
+            return false;
+        setp(buffer.data(), buffer.data() + buffer.size());
+        monitor.progress.bytesWritten += static_cast<std::size_t>(size);
+        if (monitor.progress.bytesWritten >= nextReport)
+        {
+            nextReport = monitor.progress.bytesWritten + progressBytes;
+            monitor.report(RequestStage::Write);
+        }
+        return true;
+    }
+};
+
+// ThermoDataSet queries in flight in this process, shared by all DatabaseClient instances
+auto inFlightQueries() -> SingleFlight<std::shared_ptr<const std::string>> &
+{
+    static SingleFlight<std::shared_ptr<const std::string>> queries;
+    return queries;
+}
+
 void printData(const std::string &title, const std::vector<std::string> &values)
 {
     std::cout << title << std::endl;
@@ -48,37 +154,126 @@ void printData(const std::string &title, const std::vector<std::string> &values)
 
 struct DatabaseClient::Impl
 {
-    //    arangocpp::ArangoDBCollectionAPI connect{default_data};
+    // database connection, opened by the first query that needs the server
     std::shared_ptr<arangocpp::ArangoDBCollectionAPI> dbClient;
 
-    std::string resultThermoDataSet;
+    // guards dbClient while it is opened
+    std::mutex connectionMutex;
+
+    // runs the requests of the client one at a time (the data, options and monitor below belong to the
+    // running request), held by all DatabaseClient functions but those of the cache and prefetch
+    std::mutex requestMutex;
+
+    // queried (and selected) ThermoDataSet, dumped into a DatabaseResult or streamed to a file,
+    // released at the end of each request
+    json thermoDataSet;
 
     std::vector<std::string> recjsonValues;
 
+    // a complete ThermoDataSet held in memory
+    struct CachedThermoDataSet
+    {
+        std::shared_ptr<const ThermoDataSetIndex> index;
+        // time of the download, the entry expires after options.cacheTimeToLiveSeconds
+        std::chrono::steady_clock::time_point fetched;
+        // use count of the cache when last used, the least recently used entry is dropped first
+        std::uint64_t lastUsed = 0;
+        // loaded from a file, never dropped nor expired
+        bool loaded = false;
+    };
+
+    // complete ThermoDataSets held in memory by symbol, subsets of these are selected locally
+    std::map<std::string, CachedThermoDataSet> cachedThermoDataSets;
+
+    // uses of the cached ThermoDataSets
+    std::uint64_t cacheUses = 0;
+
+    // limits of the cache (options.cacheMaxThermoDataSets and cacheTimeToLiveSeconds), guarded by cacheMutex
+    std::size_t cacheCapacity = 0;
+    std::chrono::seconds cacheTimeToLive{0};
+
     DatabaseClientOptions options;
 
     int json_indent = -1;
 
-    // Define call back function
-    arangocpp::FetchingDocumentCallback collect_results_fn;
+    // memory used by the last request
+    RequestMemoryStats lastMemory;
+
+    // cancellation and progress of the get, save and columns requests
+    RequestMonitor monitor;
 
-    auto setfunctions() -> void
+    // starts a request, and when it goes out of scope releases the data of the request and
+    // records the peak memory of the process
+    struct RequestScope
     {
-        collect_results_fn = [&](const std::string &jsondata) {
-            recjsonValues.push_back(jsondata);
-        };
-    }
+        Impl &impl;
+        std::size_t peakBefore;
+
+        explicit RequestScope(Impl &impl_) : impl(impl_), peakBefore(peakResidentMemory())
+        {
+            impl.monitor.progress = RequestProgress();
+        }
+
+        ~RequestScope()
+        {
+            impl.thermoDataSet = json();
+            auto peakAfter = peakResidentMemory();
+            impl.lastMemory.peakResidentBytes = peakAfter;
+            impl.lastMemory.peakIncreaseBytes = peakAfter > peakBefore ? peakAfter - peakBefore : 0;
+        }
+    };
+
+    // identifies the connection, queries are only coalesced between clients with the same connection
+    std::string connectionKey = "default";
+
+    // connection data, used to open further connections (background prefetch)
+    arangocpp::ArangoDBConnection connectionData = default_data;
+
+    // threads selecting the substances and reactions by elements (options.numThreads)
+    std::unique_ptr<ThreadPool> threadPool{new ThreadPool(1)};
+
+    // runs the queries with the deadlines, retries and hedging of options.requestOptions
+    std::unique_ptr<QueryExecutor> executor;
+
+    // guards cachedThermoDataSets and the cache limits, and the prefetch state below
+    std::mutex cacheMutex;
+
+    // signals the end of a background prefetch
+    std::condition_variable prefetchDone;
+
+    // ThermoDataSets to prefetch, with a copy of the options when they were queued
+    std::deque<std::pair<std::string, std::shared_ptr<const DatabaseClientOptions>>> prefetchQueue;
+
+    // background thread fetching the queued ThermoDataSets to cache, started when the queue was empty
+    std::thread prefetchThread;
+
+    // the background thread is processing the queue
+    bool prefetchRunning = false;
 
-    // read from default config
+    // number of ThermoDataSets still to be prefetched
+    std::size_t pendingPrefetches = 0;
+
+    // first error of a background prefetch
+    std::exception_ptr prefetchError;
+
+    // set when the client is destroyed, stops the background prefetch
+    std::atomic<bool> stopPrefetch{false};
+
+    // default (remote) connection, not opened before the first query
     Impl()
     {
-        setfunctions();
+        executor.reset(new QueryExecutor(connectionData));
+    }
 
+    // connection data read from a config file, not opened before the first query
+    Impl(const std::string &connection_configuration_file)
+        : connectionKey("config:" + connection_configuration_file)
+    {
         try
         {
-            // Create database connection
-            arangocpp::ArangoDBCollectionAPI connect{default_data};
-            dbClient = std::make_shared<arangocpp::ArangoDBCollectionAPI>(connect);
+            // Get Arangodb connection data( load settings from "examples-cfg.json" config file )
+            connectionData = arangocpp::connectFromConfig(connection_configuration_file);
+            executor.reset(new QueryExecutor(connectionData));
         }
         catch (arangocpp::arango_exception &e)
         {
@@ -91,36 +286,33 @@ struct DatabaseClient::Impl
         {
             std::stringstream buffer;
             buffer << "ThermoHubClient"
-                   << " std::exception" << e.what() << std::endl;
+                   << " std::exception " << e.what() << std::endl;
             throw std::runtime_error(buffer.str());
         }
         catch (...)
         {
             std::stringstream buffer;
             buffer << "ThermoHubClient"
-                   << " unknown exception" << std::endl;
+                   << " unknown exception " << std::endl;
             throw std::runtime_error(buffer.str());
         }
     }
 
-    Impl(const std::string &connection_configuration_file)
+    // the database connection, opened on first use (a failed attempt is retried by the next query)
+    auto connection() -> arangocpp::ArangoDBCollectionAPI &
     {
-        setfunctions();
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        if (dbClient)
+            return *dbClient;
 
         try
         {
-            // Get Arangodb connection data( load settings from "examples-cfg.json" config file )
-            arangocpp::ArangoDBConnection data = arangocpp::connectFromConfig(connection_configuration_file);
             // Create database connection
-            arangocpp::ArangoDBCollectionAPI connect{data};
-            dbClient = std::make_shared<arangocpp::ArangoDBCollectionAPI>(connect);
+            dbClient = std::make_shared<arangocpp::ArangoDBCollectionAPI>(connectionData);
         }
         catch (arangocpp::arango_exception &e)
         {
-            std::stringstream buffer;
-            buffer << "ThermoHubClient" << e.header() << std::endl
-                   << e.what() << std::endl;
-            throw std::runtime_error(buffer.str());
+            std::rethrow_exception(QueryExecutor::translate(e));
         }
         catch (std::exception &e)
         {
@@ -136,12 +328,20 @@ struct DatabaseClient::Impl
                    << " unknown exception " << std::endl;
             throw std::runtime_error(buffer.str());
         }
+        return *dbClient;
     }
 
-    auto idThermoDataSetFromSymbol(const std::string &symbol) -> std::string
+    // the documents selected by an AQL query on the thermodatasets collection, cancelled with the monitored request;
+    // the query functions take the options as settings, a copy for the background prefetch
+    auto select(arangocpp::ArangoDBCollectionAPI &db, const DatabaseClientOptions &settings, const arangocpp::ArangoDBQuery &aqlquery,
+                const RequestMonitor *monitor = nullptr) -> std::vector<std::string>
     {
-        recjsonValues.clear();
+        return executor->select(db, "thermodatasets", aqlquery, settings.requestOptions, monitor ? monitor->token() : nullptr);
+    }
 
+    auto idThermoDataSetFromSymbol(arangocpp::ArangoDBCollectionAPI &db, const DatabaseClientOptions &settings, const std::string &symbol,
+                                   const RequestMonitor *monitor = nullptr) -> std::string
+    {
         try
         {
             std::string query = "FOR u IN thermodatasets ";
@@ -149,16 +349,24 @@ struct DatabaseClient::Impl
             query += "RETURN u._id";
 
             arangocpp::ArangoDBQuery aqlquery(query, arangocpp::ArangoDBQuery::AQL);
-            dbClient->selectQuery("thermodatasets", aqlquery, collect_results_fn);
+            auto values = select(db, settings, aqlquery, monitor);
 
-            for (auto &i : recjsonValues)
+            for (auto &i : values)
                 while (std::find(i.begin(), i.end(), '"') != i.end())
                     i.erase(std::find(i.begin(), i.end(), '"'));
 
-            if (recjsonValues.size() == 0)
+            if (values.size() == 0)
                 return "";
             else
-                return recjsonValues[0];
+                return values[0];
+        }
+        catch (TransientError &)
+        {
+            throw;
+        }
+        catch (CancelledError &)
+        {
+            throw;
         }
         catch (arangocpp::arango_exception &e)
         {
@@ -214,155 +422,643 @@ struct DatabaseClient::Impl
         return bind_value;
     }
 
-    auto queryThermoDataSet(const std::string &idThermoDataSet, const std::vector<std::string> &substances = {},
-                            const std::vector<std::string> &classesOfSubstance = {}, const std::vector<std::string> &aggregateStates = {}) -> void
+    // AQL options object of the ThermoDataSet queries
+    static auto queryOptions(const DatabaseClientOptions &settings) -> std::string
     {
-        recjsonValues.clear();
-        try
-        {
-            std::string query_ = aql_thermofun_database_from_thermodataset;
-            std::string bind_value = "{\"idThermoDataSet\": \"" + idThermoDataSet + "\" ";
-            bind_value += makeBindList(substances, "symbol", query_);
-            bind_value += makeBindList(classesOfSubstance, "class_", query_);
-            bind_value += makeBindList(aggregateStates, "aggregate_state", query_);
-            bind_value += "}";
+        const auto &aql = settings.aqlOptions;
+        json query_options = json::object();
+        if (aql.maxPlans > 0)
+            query_options["maxPlans"] = aql.maxPlans;
+        if (!aql.optimizerRules.empty())
+            query_options["optimizer"]["rules"] = aql.optimizerRules;
+        if (aql.stream)
+            query_options["stream"] = true;
+        if (aql.maxRuntime > 0)
+            query_options["maxRuntime"] = aql.maxRuntime;
+        return query_options.dump();
+    }
 
-            arangocpp::ArangoDBQuery aqlquery(query_, arangocpp::ArangoDBQuery::AQL);
+    // properties of the RETURN object of the query, all if none are selected
+    static auto returnFields(const std::vector<std::pair<std::string, std::string>> &table, const std::set<std::string> &selected) -> std::string
+    {
+        std::string fields;
+        for (const auto &field : table)
+            if (selected.empty() || selected.count(field.first))
+                fields += (fields.empty() ? "" : ", ") + field.first + ": " + field.second;
+        return fields;
+    }
 
-            std::string options = "{ \"maxPlans\" : 1, "
-                              "  \"optimizer\" : { \"rules\" : [ \"-all\", \"+remove-unnecessary-filters\" ]  } } ";
+    static auto replaceAll(std::string &text, const std::string &from, const std::string &to) -> void
+    {
+        for (auto pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size()))
+            text.replace(pos, from.size(), to);
+    }
 
-            aqlquery.setBindVars(bind_value);
-            aqlquery.setOptions(options);
-            dbClient->selectQuery("thermodatasets", aqlquery, collect_results_fn);
+    auto queryThermoDataSetById(arangocpp::ArangoDBCollectionAPI &db, const DatabaseClientOptions &settings, const RequestMonitor *monitor, const std::string &idThermoDataSet,
+                                const std::vector<std::string> &substances = {},
+                                const std::vector<std::string> &classesOfSubstance = {},
+                                const std::vector<std::string> &aggregateStates = {},
+                                const std::set<std::string> &fields = {},
+                                bool definingReactions = false) -> std::shared_ptr<const std::string>
+    {
+        std::string query_ = aql_thermofun_database_from_thermodataset;
+        auto substanceFields = returnFields(aql_substance_fields, fields);
+        if (definingReactions)
+            substanceFields += ", " + aql_defining_reactions_field.first + ": " + aql_defining_reactions_field.second;
+        replaceAll(query_, "%substance_fields%", substanceFields);
+        replaceAll(query_, "%reaction_fields%", returnFields(aql_reaction_fields, fields));
+        std::string bind_value = "{\"idThermoDataSet\": \"" + idThermoDataSet + "\" ";
+        bind_value += makeBindList(substances, "symbol", query_);
+        bind_value += makeBindList(classesOfSubstance, "class_", query_);
+        bind_value += makeBindList(aggregateStates, "aggregate_state", query_);
+        bind_value += "}";
+
+        std::string options = queryOptions(settings);
+
+        // identical queries on the same connection running at the same time are sent once,
+        // and again if the request that sent it was cancelled
+        std::string request_key = connectionKey + (settings.velocypackTransport ? "\nvpack\n" : "\n") + bind_value + "\n" + options + "\n" + query_;
+        for (;;)
+        {
+            try
+            {
+                return queryInFlight(db, settings, monitor, idThermoDataSet, request_key, query_, bind_value, options);
+            }
+            catch (CancelledError &)
+            {
+                if (monitor && monitor->cancelled())
+                    throw;
+            }
+        }
+    }
 
-            // removing NULL
-            std::regex e("(?!,)[^,\n]+(?=null,)");
-            auto result = std::regex_replace(recjsonValues[0], e, "");
-            e = std::regex("null,");
-            resultThermoDataSet = std::regex_replace(result, e, "");
+    auto queryInFlight(arangocpp::ArangoDBCollectionAPI &db, const DatabaseClientOptions &settings, const RequestMonitor *monitor, const std::string &idThermoDataSet,
+                       const std::string &request_key, const std::string &query_, const std::string &bind_value,
+                       const std::string &options) -> std::shared_ptr<const std::string>
+    {
+        return inFlightQueries().run(request_key, [&]() -> std::shared_ptr<const std::string> {
+            try
+            {
+                std::vector<std::string> values;
+                if (settings.velocypackTransport)
+                {
+                    values = executor->selectVelocyPack(query_, bind_value, options, settings.requestOptions, monitor ? monitor->token() : nullptr);
+                }
+                else
+                {
+                    arangocpp::ArangoDBQuery aqlquery(query_, arangocpp::ArangoDBQuery::AQL);
+                    aqlquery.setBindVars(bind_value);
+                    aqlquery.setOptions(options);
+                    values = select(db, settings, aqlquery, monitor);
+                }
 
-            //printData( "Select records by AQL query", recjsonValues );
-        }
-        catch (arangocpp::arango_exception &e)
+                if (values.empty())
+                    throw std::runtime_error("ThermoDataSet " + idThermoDataSet + " query returned no result.");
+                return std::make_shared<const std::string>(std::move(values[0]));
+            }
+            catch (TransientError &)
+            {
+                throw;
+            }
+            catch (CancelledError &)
+            {
+                throw;
+            }
+            catch (arangocpp::arango_exception &e)
+            {
+                std::stringstream buffer;
+                buffer << "ThermoHubClient" << e.header() << std::endl
+                       << e.what() << std::endl;
+                throw std::runtime_error(buffer.str());
+            }
+            catch (std::exception &e)
+            {
+                std::stringstream buffer;
+                buffer << "ThermoHubClient"
+                       << " std::exception " << e.what() << std::endl
+                       << std::endl;
+                throw std::runtime_error(buffer.str());
+            }
+            catch (...)
+            {
+                std::stringstream buffer;
+                buffer << "ThermoHubClient"
+                       << " unknown exception " << std::endl;
+                throw std::runtime_error(buffer.str());
+            }
+        }, monitor ? monitor->token() : nullptr);
+    }
+
+    // parse the query result directly into the ThermoDataSet, dropping null object members and array items while parsing
+    template <typename JsonType = json>
+    static auto parseThermoDataSet(const DatabaseResult &jsondata, RequestMonitor *monitor = nullptr) -> JsonType
+    {
+        std::size_t records = 0;
+        auto document = JsonType::parse(jsondata.begin(), jsondata.end(), [&](int depth, typename JsonType::parse_event_t event, JsonType &parsed) {
+            if (event == JsonType::parse_event_t::object_end || event == JsonType::parse_event_t::array_end)
+            {
+                for (auto it = parsed.begin(); it != parsed.end();)
+                    it = it->is_null() ? parsed.erase(it) : std::next(it);
+            }
+            if (event == JsonType::parse_event_t::object_end)
+            {
+                // a record of the elements, substances or reactions
+                if (depth == 2 && ++records % progressRecords == 0 && monitor)
+                {
+                    monitor->progress.recordsProcessed = records;
+                    monitor->report(RequestStage::Parse);
+                }
+            }
+            return true;
+        });
+        if (monitor)
         {
-            std::stringstream buffer;
-            buffer << "ThermoHubClient" << e.header() << std::endl
-                   << e.what() << std::endl;
-            throw std::runtime_error(buffer.str());
+            monitor->progress.recordsProcessed = records;
+            monitor->report(RequestStage::Parse);
         }
-        catch (std::exception &e)
+        return document;
+    }
+
+    // parse the ThermoDataSet queried from the server, sent as JSON text or as VelocyPack with velocypackTransport
+    template <typename JsonType = json>
+    static auto parseQueried(const DatabaseClientOptions &settings, const std::shared_ptr<const std::string> &queried,
+                             RequestMonitor *monitor = nullptr) -> JsonType
+    {
+        if (!settings.velocypackTransport)
+            return parseThermoDataSet<JsonType>(DatabaseResult(queried), monitor);
+
+        std::size_t records = 0;
+        auto objectEnd = [&](int depth) {
+            // a record of the elements, substances or reactions
+            if (depth == 2 && ++records % progressRecords == 0 && monitor)
+            {
+                monitor->progress.recordsProcessed = records;
+                monitor->report(RequestStage::Parse);
+            }
+        };
+        auto document = decodeVelocyPack<JsonType>(VelocyPackView(queried->data(), queried->data() + queried->size()), objectEnd);
+        if (monitor)
         {
-            std::stringstream buffer;
-            buffer << "ThermoHubClient"
-                   << " std::exception " << e.what() << std::endl
-                   << std::endl;
-            throw std::runtime_error(buffer.str());
+            monitor->progress.recordsProcessed = records;
+            monitor->report(RequestStage::Parse);
         }
-        catch (...)
+        return document;
+    }
+
+    auto propertyValue(const json &record, const std::string &property) -> double
+    {
+        auto itp = record.find(property);
+        if (itp == record.end() || !itp->is_object())
+            return std::numeric_limits<double>::quiet_NaN();
+        auto itv = itp->find("values");
+        if (itv == itp->end() || !itv->is_array() || itv->empty() || !itv->front().is_number())
+            return std::numeric_limits<double>::quiet_NaN();
+        return itv->front().get<double>();
+    }
+
+    auto fillColumns(const std::string &records, const std::vector<std::string> &properties,
+                     std::vector<std::string> &symbols, std::vector<double> &values) -> void
+    {
+        auto itr = thermoDataSet.find(records);
+        if (itr == thermoDataSet.end() || !itr->is_array())
+            return;
+
+        symbols.reserve(itr->size());
+        values.reserve(itr->size() * properties.size());
+        for (const auto &record : *itr)
         {
-            std::stringstream buffer;
-            buffer << "ThermoHubClient"
-                   << " unknown exception " << std::endl;
-            throw std::runtime_error(buffer.str());
+            symbols.push_back(record.value("symbol", ""));
+            for (const auto &property : properties)
+                values.push_back(propertyValue(record, property));
         }
     }
 
-    auto removeReactionsWithReactants(json &jReactions, const std::vector<std::string> &reactants) -> void
+    auto thermoDataColumns() -> ThermoDataColumns
+    {
+        ThermoDataColumns columns;
+        fillColumns("substances", columns.substanceProperties, columns.substanceSymbols, columns.substanceValues);
+        fillColumns("reactions", columns.reactionProperties, columns.reactionSymbols, columns.reactionValues);
+        return columns;
+    }
+
+    // the complete ThermoDataSet held by the client, or downloaded for the request
+    auto thermoDataSetIndex(const std::string &thermodataset) -> std::shared_ptr<const ThermoDataSetIndex>
+    {
+        if (auto cached = cachedThermoDataSet(thermodataset))
+            return cached;
+        if (options.cacheThermoDataSets)
+            return cacheThermoDataSet(connection(), options, thermodataset, &monitor);
+        return downloadThermoDataSet(connection(), options, thermodataset, &monitor);
+    }
+
+    // the complete ThermoDataSet held by the client for a request without selection, nullptr if the request
+    // goes to the server or to the cache daemon
+    auto completeThermoDataSet(const std::string &thermodataset, const std::vector<std::string> &elements)
+        -> std::shared_ptr<const ThermoDataSetIndex>
+    {
+        if (!elements.empty() || !options.cacheDaemonSocket.empty())
+            return nullptr;
+        auto cached = cachedThermoDataSet(thermodataset);
+        if (!cached && options.cacheThermoDataSets)
+            cached = cacheThermoDataSet(connection(), options, thermodataset, &monitor);
+        return cached;
+    }
+
+    auto formulaMatrix(const std::string &thermodataset, const std::vector<std::string> &elements, bool chargeRow) -> FormulaMatrix
     {
-        for (auto it = jReactions.begin(); it != jReactions.end(); ++it)
+        if (auto complete = completeThermoDataSet(thermodataset, elements))
+            return complete->formulaMatrix(chargeRow);
+
+        selectDatabase(thermodataset, elements, {}, {}, {});
+        monitor.report(RequestStage::Filter);
+        return ThermoHubClient::formulaMatrix(thermoDataSet, chargeRow, threadPool.get());
+    }
+
+    auto reactionMatrix(const std::string &thermodataset, const std::vector<std::string> &elements) -> ReactionMatrix
+    {
+        if (auto complete = completeThermoDataSet(thermodataset, elements))
+            return ThermoHubClient::reactionMatrix(complete->thermoDataSet());
+
+        selectDatabase(thermodataset, elements, {}, {}, {});
+        monitor.report(RequestStage::Filter);
+        return ThermoHubClient::reactionMatrix(thermoDataSet);
+    }
+
+    auto reactionBalance(const std::string &thermodataset, const std::vector<std::string> &elements, double tolerance) -> ReactionBalance
+    {
+        if (auto complete = completeThermoDataSet(thermodataset, elements))
         {
-            for (auto it2 = it.value()["reactants"].begin(); it2 != it.value()["reactants"].end(); ++it2)
-            {
-                if (std::find(reactants.begin(), reactants.end(), it2.value()["symbol"]) != reactants.end())
-                {
-                    jReactions.erase(it--);
-                    break;
-                }
-            }
+            auto reactions = ThermoHubClient::reactionMatrix(complete->thermoDataSet());
+            return ThermoHubClient::checkReactionBalance(reactions, complete->formulaMatrix(true), tolerance, threadPool.get());
         }
+
+        selectDatabase(thermodataset, elements, {}, {}, {});
+        monitor.report(RequestStage::Filter);
+        auto reactions = ThermoHubClient::reactionMatrix(thermoDataSet);
+        auto formulas = ThermoHubClient::formulaMatrix(thermoDataSet, true, threadPool.get());
+        return ThermoHubClient::checkReactionBalance(reactions, formulas, tolerance, threadPool.get());
     }
 
-    auto testElementsInFormula(const std::string &formula, const std::vector<std::string> &elements) -> bool
+    auto molarMassCharge(const std::string &thermodataset, const std::vector<std::string> &elements, double tolerance) -> MolarMassCharge
     {
-        FormulaParser::ChemicalFormulaParser parser;
+        if (auto complete = completeThermoDataSet(thermodataset, elements))
+            return ThermoHubClient::molarMassCharge(complete->thermoDataSet(), complete->formulaCompositions(), tolerance);
+
+        selectDatabase(thermodataset, elements, {}, {}, {});
+        monitor.report(RequestStage::Filter);
+        return ThermoHubClient::molarMassCharge(thermoDataSet, tolerance, threadPool.get());
+    }
 
-        for (auto formelm : parser.parse(formula))
+    auto selectDatabase(const std::string &thermodataset, const std::vector<std::string> &elements,
+                        const std::vector<std::string> &substances,
+                        const std::vector<std::string> &classesOfSubstance,
+                        const std::vector<std::string> &aggregateStates) -> void
+    {
+        if (!options.cacheDaemonSocket.empty())
         {
-            auto itr = elements.begin();
-            while (itr != elements.end())
-            {
-                if (formelm.symbol == *itr)
-                    break;
-                itr++;
-            }
-            if (itr == elements.end())
-                return false;
+            auto request = daemonRequest(thermodataset, elements, substances, classesOfSubstance, aggregateStates);
+            request.jsonIndent = -1;
+            monitor.report(RequestStage::Fetch);
+            auto received = requestFromCacheDaemon(options.cacheDaemonSocket, request);
+            monitor.progress.bytesReceived = received.size();
+            monitor.report(RequestStage::Fetch);
+            thermoDataSet = parseThermoDataSet(received, &monitor);
+            return;
         }
-        return true;
+
+        auto selected = selectedProperties();
+        auto cached = cachedThermoDataSet(thermodataset);
+        if (!cached && options.cacheThermoDataSets)
+            cached = cacheThermoDataSet(connection(), options, thermodataset, &monitor);
+        if (cached)
+        {
+            monitor.report(RequestStage::Filter);
+            thermoDataSet = cached->subset(elements, substances, classesOfSubstance, aggregateStates, options.filterCharge);
+            removeUnselectedProperties(thermoDataSet, selected);
+            return;
+        }
+        selectFromServer(thermoDataSet, thermodataset, elements, substances, classesOfSubstance, aggregateStates, selected);
+    }
+
+    // query a ThermoDataSet subset from the server into document, and select the data containing the elements
+    template <typename JsonType>
+    auto selectFromServer(JsonType &document, const std::string &thermodataset, const std::vector<std::string> &elements,
+                          const std::vector<std::string> &substances,
+                          const std::vector<std::string> &classesOfSubstance,
+                          const std::vector<std::string> &aggregateStates,
+                          const std::set<std::string> &selected) -> void
+    {
+        // the selection by elements needs the formulas of the substances and the reactants of the reactions
+        auto fields = selected;
+        if (!selected.empty() && !elements.empty())
+            fields.insert({"formula", "reactants"});
+        document = parseQueried<JsonType>(options, queryThermoDataSet(connection(), options, &monitor, thermodataset, substances, classesOfSubstance, aggregateStates, fields), &monitor);
+        monitor.report(RequestStage::Filter);
+        if (!elements.empty())
+            ElementFilter(elements, options.filterCharge).select(document, threadPool.get());
+        removeUnselectedProperties(document, selected);
+    }
+
+    // query a ThermoDataSet subset from the server, and select the data containing the elements on the text of
+    // the query result; the compact result is the text of selectFromServer and dump()
+    auto selectTextFromServer(const std::string &thermodataset, const std::vector<std::string> &elements,
+                              const std::vector<std::string> &substances,
+                              const std::vector<std::string> &classesOfSubstance,
+                              const std::vector<std::string> &aggregateStates,
+                              const std::set<std::string> &selected) -> DatabaseResult
+    {
+        auto fields = selected;
+        if (!selected.empty())
+            fields.insert({"formula", "reactants"});
+        auto received = queryThermoDataSet(connection(), options, &monitor, thermodataset, substances, classesOfSubstance, aggregateStates, fields);
+        monitor.report(RequestStage::Filter);
+        return DatabaseResult(ElementFilter(elements, options.filterCharge).selectText(JsonView::document(*received), selected, threadPool.get()));
     }
 
-    auto selectDataContainingElements(const std::vector<std::string> &elems) -> void
+    auto daemonRequest(const std::string &thermodataset, const std::vector<std::string> &elements,
+                       const std::vector<std::string> &substances,
+                       const std::vector<std::string> &classesOfSubstance,
+                       const std::vector<std::string> &aggregateStates) const -> CacheDaemonRequest
     {
-        std::vector<std::string> elements = elems;
-        json jThermoDataSet = json::parse(resultThermoDataSet);
-        if (elements.size() == 0)
+        CacheDaemonRequest request;
+        request.thermodataset = thermodataset;
+        request.elements = elements;
+        request.substances = substances;
+        request.classesOfSubstance = classesOfSubstance;
+        request.aggregateStates = aggregateStates;
+        request.selectedProperties = options.selectedProperties;
+        request.filterCharge = options.filterCharge;
+        request.jsonIndent = json_indent;
+        return request;
+    }
+
+    // properties of substances and reactions selected in the options (with the symbol), empty if all are returned
+    auto selectedProperties() const -> std::set<std::string>
+    {
+        std::set<std::string> selected;
+        for (const auto &property : options.selectedProperties)
         {
-            resultThermoDataSet = jThermoDataSet.dump(json_indent);
+            auto known = [&property](const std::pair<std::string, std::string> &field) { return field.first == property; };
+            if (std::none_of(aql_substance_fields.begin(), aql_substance_fields.end(), known) &&
+                std::none_of(aql_reaction_fields.begin(), aql_reaction_fields.end(), known))
+                throw std::runtime_error("ThermoHubClient: unknown substance or reaction property " + property);
+            selected.insert(property);
+        }
+        if (!selected.empty())
+            selected.insert("symbol");
+        return selected;
+    }
+
+    // remove the properties used only for the selection from the substances and reactions
+    template <typename JsonType>
+    static auto removeUnselectedProperties(JsonType &document, const std::set<std::string> &selected) -> void
+    {
+        if (selected.empty())
             return;
+        for (const auto &name : {"substances", "reactions"})
+        {
+            auto records = document.find(name);
+            if (records == document.end())
+                continue;
+            for (auto &record : *records)
+                for (auto it = record.begin(); it != record.end();)
+                    it = selected.count(it.key()) ? std::next(it) : record.erase(it);
+        }
+    }
+
+    // the ThermoDataSet held in memory, nullptr if it is not held or has expired
+    auto cachedThermoDataSet(const std::string &thermodataset) -> std::shared_ptr<const ThermoDataSetIndex>
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto itr = cachedThermoDataSets.find(thermodataset);
+        if (itr == cachedThermoDataSets.end())
+            return nullptr;
+        if (!itr->second.loaded && cacheTimeToLive.count() > 0 &&
+            std::chrono::steady_clock::now() - itr->second.fetched >= cacheTimeToLive)
+        {
+            cachedThermoDataSets.erase(itr);
+            return nullptr;
         }
+        itr->second.lastUsed = ++cacheUses;
+        return itr->second.index;
+    }
 
-        if (!options.filterCharge) // charge is considered by default if not filtered
-            elements.push_back("Zz");
+    // download the complete ThermoDataSet, with the reactions defining each substance (the background
+    // prefetch has no monitor)
+    auto downloadThermoDataSet(arangocpp::ArangoDBCollectionAPI &db, const DatabaseClientOptions &settings, const std::string &thermodataset,
+                               RequestMonitor *monitor = nullptr) -> std::shared_ptr<const ThermoDataSetIndex>
+    {
+        return std::make_shared<const ThermoDataSetIndex>(parseQueried(settings, queryThermoDataSet(db, settings, monitor, thermodataset, {}, {}, {}, {}, true), monitor));
+    }
 
-        json jElements = jThermoDataSet["elements"];
-        for (auto it = jElements.begin(); it != jElements.end(); ++it)
+    // download the complete ThermoDataSet and keep it in memory
+    auto cacheThermoDataSet(arangocpp::ArangoDBCollectionAPI &db, const DatabaseClientOptions &settings, const std::string &thermodataset,
+                            RequestMonitor *monitor = nullptr) -> std::shared_ptr<const ThermoDataSetIndex>
+    {
+        auto complete = downloadThermoDataSet(db, settings, thermodataset, monitor);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto &cached = cachedThermoDataSets[thermodataset];
+        // a ThermoDataSet loaded from a file in the meantime is kept
+        if (!cached.loaded)
         {
-            if (std::find(elements.begin(), elements.end(), it.value()["symbol"]) == elements.end())
-                jElements.erase(it--);
+            cached.index = complete;
+            cached.fetched = std::chrono::steady_clock::now();
         }
+        cached.lastUsed = ++cacheUses;
+        auto index = cached.index;
+        dropLeastRecentlyUsed();
+        return index;
+    }
 
-        auto jSubstances = jThermoDataSet["substances"];
-        std::vector<std::string> substances;
-        for (auto it = jSubstances.begin(); it != jSubstances.end(); ++it)
+    // drop the least recently used downloaded ThermoDataSets over the capacity of the cache (cacheMutex locked)
+    auto dropLeastRecentlyUsed() -> void
+    {
+        if (cacheCapacity == 0)
+            return;
+        for (;;)
         {
-            if (!testElementsInFormula(it.value()["formula"], elements))
+            auto oldest = cachedThermoDataSets.end();
+            std::size_t downloaded = 0;
+            for (auto itr = cachedThermoDataSets.begin(); itr != cachedThermoDataSets.end(); ++itr)
             {
-                substances.push_back(it.value()["symbol"]);
-                jSubstances.erase(it--);
+                if (itr->second.loaded)
+                    continue;
+                ++downloaded;
+                if (oldest == cachedThermoDataSets.end() || itr->second.lastUsed < oldest->second.lastUsed)
+                    oldest = itr;
             }
+            if (downloaded <= cacheCapacity)
+                return;
+            cachedThermoDataSets.erase(oldest);
         }
+    }
 
-        auto jReactions = jThermoDataSet["reactions"];
-        removeReactionsWithReactants(jReactions, substances);
+    // fetch and cache ThermoDataSets in the background thread, with the options given when they were queued
+    auto startPrefetch(const std::vector<std::string> &thermodatasets) -> void
+    {
+        if (thermodatasets.empty())
+            return;
+        auto settings = std::make_shared<const DatabaseClientOptions>(options);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (const auto &thermodataset : thermodatasets)
+            prefetchQueue.emplace_back(thermodataset, settings);
+        pendingPrefetches += thermodatasets.size();
+        if (prefetchRunning)
+            return;
+        // the thread of an earlier prefetch has emptied the queue and is returning
+        if (prefetchThread.joinable())
+            prefetchThread.join();
+        prefetchRunning = true;
+        prefetchThread = std::thread([this]() { prefetch(); });
+    }
 
-        jThermoDataSet.at("elements") = jElements;
-        jThermoDataSet.at("substances") = jSubstances;
-        jThermoDataSet.at("reactions") = jReactions;
+    // the background thread, using its own connection, returns when the queue is empty
+    auto prefetch() -> void
+    {
+        std::unique_ptr<arangocpp::ArangoDBCollectionAPI> db;
+        for (;;)
+        {
+            std::pair<std::string, std::shared_ptr<const DatabaseClientOptions>> next;
+            {
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                if (prefetchQueue.empty() || stopPrefetch)
+                {
+                    pendingPrefetches -= prefetchQueue.size();
+                    prefetchQueue.clear();
+                    prefetchRunning = false;
+                    prefetchDone.notify_all();
+                    return;
+                }
+                next = std::move(prefetchQueue.front());
+                prefetchQueue.pop_front();
+            }
+            try
+            {
+                if (!cachedThermoDataSet(next.first))
+                {
+                    if (!db)
+                        db.reset(new arangocpp::ArangoDBCollectionAPI(connectionData));
+                    cacheThermoDataSet(*db, *next.second, next.first);
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                if (!prefetchError)
+                    prefetchError = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            --pendingPrefetches;
+            prefetchDone.notify_all();
+        }
+    }
+
+    auto isReady() -> bool
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return pendingPrefetches == 0;
+    }
+
+    auto waitUntilReady(int timeout_ms) -> bool
+    {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        auto ready = [this]() { return pendingPrefetches == 0; };
+        if (timeout_ms < 0)
+            prefetchDone.wait(lock, ready);
+        else if (!prefetchDone.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready))
+            return false;
+        if (prefetchError)
+            std::rethrow_exception(prefetchError);
+        return true;
+    }
+
+    ~Impl()
+    {
+        stopPrefetch = true;
+        if (prefetchThread.joinable())
+            prefetchThread.join();
+    }
+
+    // query the ThermoDataSet, reporting the fetch stage to the monitor (if any)
+    auto queryThermoDataSet(arangocpp::ArangoDBCollectionAPI &db, const DatabaseClientOptions &settings, RequestMonitor *monitor, const std::string &thermodataset,
+                            const std::vector<std::string> &substances,
+                            const std::vector<std::string> &classesOfSubstance,
+                            const std::vector<std::string> &aggregateStates,
+                            const std::set<std::string> &fields = {},
+                            bool definingReactions = false) -> std::shared_ptr<const std::string>
+    {
+        if (monitor)
+            monitor->report(RequestStage::Fetch);
 
-        resultThermoDataSet = jThermoDataSet.dump(json_indent);
+        std::string idThermoDataSet = idThermoDataSetFromSymbol(db, settings, thermodataset, monitor);
+
+        if (idThermoDataSet == "")
+            throw std::runtime_error("Thermodataset with symbol " + thermodataset + " was not found.");
+        auto queried = queryThermoDataSetById(db, settings, monitor, idThermoDataSet, substances, classesOfSubstance, aggregateStates, fields, definingReactions);
+        if (monitor)
+        {
+            monitor->progress.bytesReceived = queried->size();
+            monitor->report(RequestStage::Fetch);
+        }
+        return queried;
     }
 
     auto getDatabase(const std::string &thermodataset, const std::vector<std::string> &elements,
                      const std::vector<std::string> &substances,
                      const std::vector<std::string> &classesOfSubstance,
-                     const std::vector<std::string> &aggregateStates) -> const std::string &
+                     const std::vector<std::string> &aggregateStates) -> DatabaseResult
     {
-        std::string idThermoDataSet = idThermoDataSetFromSymbol(thermodataset);
+        if (!options.cacheDaemonSocket.empty())
+        {
+            monitor.report(RequestStage::Fetch);
+            // the result views the shared memory of the daemon answer, no copy is made
+            auto result = requestFromCacheDaemon(options.cacheDaemonSocket,
+                                                 daemonRequest(thermodataset, elements, substances, classesOfSubstance, aggregateStates));
+            monitor.progress.bytesReceived = result.size();
+            monitor.report(RequestStage::Fetch);
+            return result;
+        }
 
-        if (idThermoDataSet == "")
-            throw std::runtime_error("Thermodataset with symbol " + thermodataset + " was not found.");
-        queryThermoDataSet(idThermoDataSet, substances, classesOfSubstance, aggregateStates);
-        selectDataContainingElements(elements);
-        return resultThermoDataSet;
+        if (!options.cacheThermoDataSets && !cachedThermoDataSet(thermodataset))
+        {
+            if (json_indent < 0 && !elements.empty() && !options.velocypackTransport)
+                return selectTextFromServer(thermodataset, elements, substances, classesOfSubstance, aggregateStates, selectedProperties());
+
+            // the query result is parsed, selected and dumped in an arena released with the request
+            RequestArena arena;
+            ArenaScope scope(arena);
+            arena_json document;
+            selectFromServer(document, thermodataset, elements, substances, classesOfSubstance, aggregateStates, selectedProperties());
+            return DatabaseResult(document.dump(json_indent));
+        }
+
+        selectDatabase(thermodataset, elements, substances, classesOfSubstance, aggregateStates);
+        return DatabaseResult(thermoDataSet.dump(json_indent));
     }
 
     auto saveDatabase(const std::string &fileName) -> void
     {
         try
         {
-            std::ofstream file(fileName);
-            file << resultThermoDataSet;
+            // serialize the selected ThermoDataSet straight into the file stream, as thermoDataSet.dump(json_indent)
+            // a cancelled write throws from the stream buffer, and the partly written file is removed
+            monitor.report(RequestStage::Write);
+            writeDatabaseFile(fileName, [this](std::ostream &file) {
+                ProgressStreamBuffer buffer(file.rdbuf(), monitor);
+                std::ostream stream(&buffer);
+                stream.exceptions(std::ios::badbit);
+                // a zero stream width writes compact json, unlike dump(0) which writes one value per line
+                if (json_indent == 0)
+                    stream << thermoDataSet.dump(0);
+                else
+                    stream << std::setw(std::max(json_indent, 0)) << thermoDataSet;
+                stream.flush();
+            });
+            monitor.report(RequestStage::Write);
+        }
+        catch (CancelledError &)
+        {
+            throw;
         }
         catch (json::exception &ex)
         {
@@ -395,7 +1091,7 @@ struct DatabaseClient::Impl
 
         std::string query = "FOR u IN thermodatasets RETURN u.properties.symbol";
         arangocpp::ArangoDBQuery aqlquery(query, arangocpp::ArangoDBQuery::AQL);
-        dbClient->selectQuery("thermodatasets", aqlquery, collect_results_fn);
+        recjsonValues = select(connection(), options, aqlquery);
         //    printData( "Select records by AQL query", recjsonValues );
 
         return recjsonValues;
@@ -409,7 +1105,7 @@ struct DatabaseClient::Impl
         query += "FILTER u.properties.symbol == \"" + thermodataset + "\"";
         query += "FOR e, b IN 1..1 INBOUND u basis SORT e.properties.symbol RETURN e.properties.symbol";
         arangocpp::ArangoDBQuery aqlquery(query, arangocpp::ArangoDBQuery::AQL);
-        dbClient->selectQuery("thermodatasets", aqlquery, collect_results_fn);
+        recjsonValues = select(connection(), options, aqlquery);
         //    printData( "Select records by AQL query", recjsonValues );
 
         return recjsonValues;
@@ -423,7 +1119,7 @@ struct DatabaseClient::Impl
         query += "FILTER u.properties.symbol == \"" + thermodataset + "\"";
         query += "FOR s, p IN 1..1 INBOUND u pulls SORT s.properties.symbol RETURN s.properties.symbol";
         arangocpp::ArangoDBQuery aqlquery(query, arangocpp::ArangoDBQuery::AQL);
-        dbClient->selectQuery("thermodatasets", aqlquery, collect_results_fn);
+        recjsonValues = select(connection(), options, aqlquery);
         //    printData( "Select records by AQL query", recjsonValues );
 
         return recjsonValues;
@@ -438,7 +1134,7 @@ struct DatabaseClient::Impl
         query += "FOR s, p IN 1..1 INBOUND u pulls ";
         query += "FOR r, t IN 1..1 OUTBOUND s takes SORT r.properties.symbol RETURN r.properties.symbol";
         arangocpp::ArangoDBQuery aqlquery(query, arangocpp::ArangoDBQuery::AQL);
-        dbClient->selectQuery("thermodatasets", aqlquery, collect_results_fn);
+        recjsonValues = select(connection(), options, aqlquery);
         //    printData( "Select records by AQL query", recjsonValues );
 
         return recjsonValues;
@@ -452,7 +1148,7 @@ struct DatabaseClient::Impl
         query += "FILTER u.properties.symbol == \"" + thermodataset + "\"";
         query += "FOR s, p IN 1..1 INBOUND u pulls RETURN DISTINCT s.properties.class_";
         arangocpp::ArangoDBQuery aqlquery(query, arangocpp::ArangoDBQuery::AQL);
-        dbClient->selectQuery("thermodatasets", aqlquery, collect_results_fn);
+        recjsonValues = select(connection(), options, aqlquery);
         //    printData( "Select records by AQL query", recjsonValues );
 
         return recjsonValues;
@@ -466,11 +1162,16 @@ struct DatabaseClient::Impl
         query += "FILTER u.properties.symbol == \"" + thermodataset + "\"";
         query += "FOR s, p IN 1..1 INBOUND u pulls RETURN DISTINCT s.properties.aggregate_state";
         arangocpp::ArangoDBQuery aqlquery(query, arangocpp::ArangoDBQuery::AQL);
-        dbClient->selectQuery("thermodatasets", aqlquery, collect_results_fn);
+        recjsonValues = select(connection(), options, aqlquery);
         //    printData( "Select records by AQL query", recjsonValues );
 
         return recjsonValues;
     }
+
+    auto databaseFileName(const std::string &thermodataset, const std::string &suffix) -> std::string
+    {
+        return thermodataset + suffix + ".json" + compressionSuffix(options.fileCompression);
+    }
 };
 
 DatabaseClient::DatabaseClient()
@@ -483,6 +1184,12 @@ DatabaseClient::DatabaseClient(const std::string &connection_configuration)
 {
 }
 
+DatabaseClient::DatabaseClient(const std::string &connection_configuration, const DatabaseClientOptions &options)
+    : DatabaseClient(connection_configuration)
+{
+    setOptions(options);
+}
+
 auto DatabaseClient::operator=(DatabaseClient other) -> DatabaseClient &
 {
     pimpl = std::move(other.pimpl);
@@ -493,14 +1200,18 @@ DatabaseClient::~DatabaseClient()
 {
 }
 
-auto DatabaseClient::getDatabase(const std::string &thermodataset) const -> const std::string &
+auto DatabaseClient::getDatabase(const std::string &thermodataset) const -> DatabaseResult
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
     pimpl->json_indent = pimpl->options.json_indent_get;
     return pimpl->getDatabase(thermodataset, {}, {}, {}, {});
 }
 
-auto DatabaseClient::getDatabaseContainingElements(const std::string &thermodataset, const std::vector<std::string> &elements) const -> const std::string &
+auto DatabaseClient::getDatabaseContainingElements(const std::string &thermodataset, const std::vector<std::string> &elements) const -> DatabaseResult
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
     pimpl->json_indent = pimpl->options.json_indent_get;
     return pimpl->getDatabase(thermodataset, elements, {}, {}, {});
 }
@@ -508,24 +1219,79 @@ auto DatabaseClient::getDatabaseContainingElements(const std::string &thermodata
 auto DatabaseClient::getDatabaseSubset(const std::string &thermodataset, const std::vector<std::string> &elements,
                                        const std::vector<std::string> &substances,
                                        const std::vector<std::string> &classesOfSubstance,
-                                       const std::vector<std::string> &aggregateStates) const -> const std::string &
+                                       const std::vector<std::string> &aggregateStates) const -> DatabaseResult
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
     pimpl->json_indent = pimpl->options.json_indent_get;
     return pimpl->getDatabase(thermodataset, elements, substances, classesOfSubstance, aggregateStates);
 }
 
+auto DatabaseClient::getDatabaseColumns(const std::string &thermodataset, const std::vector<std::string> &elements,
+                                        const std::vector<std::string> &substances,
+                                        const std::vector<std::string> &classesOfSubstance,
+                                        const std::vector<std::string> &aggregateStates) const -> ThermoDataColumns
+{
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
+    pimpl->selectDatabase(thermodataset, elements, substances, classesOfSubstance, aggregateStates);
+    return pimpl->thermoDataColumns();
+}
+
+auto DatabaseClient::getFormulaMatrix(const std::string &thermodataset, const std::vector<std::string> &elements,
+                                      bool chargeRow) const -> FormulaMatrix
+{
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
+    return pimpl->formulaMatrix(thermodataset, elements, chargeRow);
+}
+
+auto DatabaseClient::getReactionMatrix(const std::string &thermodataset, const std::vector<std::string> &elements) const -> ReactionMatrix
+{
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
+    return pimpl->reactionMatrix(thermodataset, elements);
+}
+
+auto DatabaseClient::checkReactionBalance(const std::string &thermodataset, const std::vector<std::string> &elements,
+                                          double tolerance) const -> ReactionBalance
+{
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
+    return pimpl->reactionBalance(thermodataset, elements, tolerance);
+}
+
+auto DatabaseClient::getMolarMassCharge(const std::string &thermodataset, const std::vector<std::string> &elements,
+                                        double tolerance) const -> MolarMassCharge
+{
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
+    return pimpl->molarMassCharge(thermodataset, elements, tolerance);
+}
+
+auto DatabaseClient::getThermoDataSetIndex(const std::string &thermodataset) const -> std::shared_ptr<const ThermoDataSetIndex>
+{
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
+    return pimpl->thermoDataSetIndex(thermodataset);
+}
+
 auto DatabaseClient::saveDatabase(const std::string &thermodataset) -> void
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
     pimpl->json_indent = pimpl->options.json_indent_save;
-    pimpl->getDatabase(thermodataset, {}, {}, {}, {});
-    pimpl->saveDatabase(thermodataset + pimpl->options.databaseFileSuffix + ".json");
+    pimpl->selectDatabase(thermodataset, {}, {}, {}, {});
+    pimpl->saveDatabase(pimpl->databaseFileName(thermodataset, pimpl->options.databaseFileSuffix));
 }
 
 auto DatabaseClient::saveDatabaseContainingElements(const std::string &thermodataset, const std::vector<std::string> &elements) -> void
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
     pimpl->json_indent = pimpl->options.json_indent_save;
-    pimpl->getDatabase(thermodataset, elements, {}, {}, {});
-    pimpl->saveDatabase(thermodataset + pimpl->options.subsetFileSuffix + ".json");
+    pimpl->selectDatabase(thermodataset, elements, {}, {}, {});
+    pimpl->saveDatabase(pimpl->databaseFileName(thermodataset, pimpl->options.subsetFileSuffix));
 }
 
 auto DatabaseClient::saveDatabaseSubset(const std::string &thermodataset, const std::vector<std::string> &elements,
@@ -533,44 +1299,106 @@ auto DatabaseClient::saveDatabaseSubset(const std::string &thermodataset, const
                                         const std::vector<std::string> &classesOfSubstance,
                                         const std::vector<std::string> &aggregateStates) -> void
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    Impl::RequestScope scope(*pimpl);
     pimpl->json_indent = pimpl->options.json_indent_save;
-    pimpl->getDatabase(thermodataset, elements, substances, classesOfSubstance, aggregateStates);
-    pimpl->saveDatabase(thermodataset + pimpl->options.subsetFileSuffix + ".json");
+    pimpl->selectDatabase(thermodataset, elements, substances, classesOfSubstance, aggregateStates);
+    pimpl->saveDatabase(pimpl->databaseFileName(thermodataset, pimpl->options.subsetFileSuffix));
 }
 
 auto DatabaseClient::availableThermoDataSets() -> std::vector<std::string>
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
     return pimpl->availableThermoDataSets();
 }
 
 auto DatabaseClient::elementsInThermoDataSet(const std::string &thermodataset) -> std::vector<std::string>
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
     return pimpl->elementsInThermoDataSet(thermodataset);
 }
 
 auto DatabaseClient::substancesInThermoDataSet(const std::string &thermodataset) -> std::vector<std::string>
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
     return pimpl->substancesInThermoDataSet(thermodataset);
 }
 
 auto DatabaseClient::reactionsInThermoDataSet(const std::string &thermodataset) -> std::vector<std::string>
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
     return pimpl->reactionsInThermoDataSet(thermodataset);
 }
 
 auto DatabaseClient::substanceClassesInThermoDataSet(const std::string &thermodataset) -> std::vector<std::string>
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
     return pimpl->substanceClassesInThermoDataSet(thermodataset);
 }
 
 auto DatabaseClient::substanceAggregateStatesInThermoDataSet(const std::string &thermodataset) -> std::vector<std::string>
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
     return pimpl->substanceAggregateStatesInThermoDataSet(thermodataset);
 }
 
+auto DatabaseClient::loadThermoDataSet(const std::string &thermodataset, const std::string &fileName) -> void
+{
+    Impl::CachedThermoDataSet loaded;
+    loaded.index = std::make_shared<const ThermoDataSetIndex>(ThermoDataSetIndex::fromFile(fileName));
+    loaded.loaded = true;
+    std::lock_guard<std::mutex> lock(pimpl->cacheMutex);
+    loaded.lastUsed = ++pimpl->cacheUses;
+    pimpl->cachedThermoDataSets[thermodataset] = loaded;
+}
+
+auto DatabaseClient::clearCachedThermoDataSets() -> void
+{
+    std::lock_guard<std::mutex> lock(pimpl->cacheMutex);
+    pimpl->cachedThermoDataSets.clear();
+}
+
+auto DatabaseClient::lastRequestMemory() const -> RequestMemoryStats
+{
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    return pimpl->lastMemory;
+}
+
+auto DatabaseClient::isReady() const -> bool
+{
+    return pimpl->isReady();
+}
+
+auto DatabaseClient::waitUntilReady(int timeoutMilliseconds) const -> bool
+{
+    return pimpl->waitUntilReady(timeoutMilliseconds);
+}
+
+auto DatabaseClient::setCancellationToken(const CancellationToken &token) -> void
+{
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    pimpl->monitor.cancellation = std::make_shared<const CancellationToken>(token);
+}
+
+auto DatabaseClient::setProgressCallback(const ProgressCallback &callback) -> void
+{
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    pimpl->monitor.callback = callback;
+}
+
 auto DatabaseClient::setOptions(const DatabaseClientOptions &options) -> void
 {
+    std::lock_guard<std::mutex> lock(pimpl->requestMutex);
+    if (options.numThreads != pimpl->options.numThreads)
+        pimpl->threadPool.reset(new ThreadPool(static_cast<std::size_t>(std::max(options.numThreads, 0))));
     pimpl->options = options;
+    {
+        std::lock_guard<std::mutex> cacheLock(pimpl->cacheMutex);
+        pimpl->cacheCapacity = static_cast<std::size_t>(std::max(options.cacheMaxThermoDataSets, 0));
+        pimpl->cacheTimeToLive = std::chrono::seconds(std::max(options.cacheTimeToLiveSeconds, 0));
+        pimpl->dropLeastRecentlyUsed();
+    }
+    pimpl->startPrefetch(options.prefetchThermoDataSets);
 }
 
 } // namespace ThermoHubClient
@@ -13,14 +13,80 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
 
+#pragma once
+
 // C++ includes
+#include <stdexcept>
 #include <string>
 #include <memory>
 #include <vector>
 
+// ThermoHubClient includes
+#include "FormulaMatrix.h"
+#include "MolarMassCharge.h"
+#include "ReactionMatrix.h"
+#include "ThermoDataColumns.h"
+#include "DatabaseFile.h"
+#include "DatabaseResult.h"
+#include "RequestControl.h"
+
 namespace ThermoHubClient
 {
 
+class ThermoDataSetIndex;
+
+/// Execution options of the AQL queries of ThermoDataSets
+struct AqlQueryOptions
+{
+    // maximum number of execution plans considered by the optimizer (0 for the server default)
+    int maxPlans = 1;
+    // optimizer rules, "-all" disables all rules, "+name" enables and "-name" disables a rule
+    // (empty for the server default rules)
+    std::vector<std::string> optimizerRules = {"-all", "+remove-unnecessary-filters"};
+    // stream the results instead of computing them completely before the first batch is sent
+    bool stream = false;
+    // abort queries running longer than this number of seconds (0 for no limit)
+    double maxRuntime = 0;
+};
+
+/// Deadlines, retries and hedging of the queries to the ThermoHub server
+struct RequestOptions
+{
+    // deadline of one query attempt in milliseconds, TimeoutError when exceeded (0 for no deadline)
+    int timeoutMilliseconds = 0;
+    // deadline of a query with all its attempts and backoff delays in milliseconds, TimeoutError
+    // when exceeded (0 for no deadline)
+    int totalTimeoutMilliseconds = 0;
+    // retries of a query after a TransientError (connection failure, server overload, timeout)
+    int maxRetries = 0;
+    // delay before the first retry in milliseconds, doubled for each further retry;
+    // the actual delay is a random value up to it (jitter)
+    int backoffMilliseconds = 100;
+    // upper limit of the delay between retries in milliseconds
+    int maxBackoffMilliseconds = 5000;
+    // send a duplicate query on another connection when no result arrived after this many
+    // milliseconds (e.g. the p95 latency), the first result is used (0 for no hedging)
+    int hedgeAfterMilliseconds = 0;
+    // attempts of a client running at a time in their own threads (0 for no limit); an attempt left
+    // behind by a timeout keeps its thread and connection until the server answers it, further
+    // attempts wait for a place and hedges are skipped
+    int maxAttemptsInFlight = 8;
+};
+
+/// Error of a request that may succeed when repeated (connection failure, server overload, timeout)
+class TransientError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/// A query to the ThermoHub server did not finish before its deadline
+class TimeoutError : public TransientError
+{
+public:
+    using TransientError::TransientError;
+};
+
 struct DatabaseClientOptions
 {
     // number of spaces in the json indentation (in saved file)
@@ -34,15 +100,63 @@ struct DatabaseClientOptions
     // subset database file suffix, when saving a subset of a ThermoDataSet based on a
     // list of elements, substances, aggregate state
     std::string subsetFileSuffix = "-subset-thermofun";
+    // compression of the saved database files, adds .gz or .zst to the file name
+    FileCompression fileCompression = FileCompression::Plain;
+    // keep the complete ThermoDataSets in memory after the first request, and select
+    // all following subsets of the same ThermoDataSet locally, without querying the server
+    bool cacheThermoDataSets = false;
+    // complete ThermoDataSets downloaded and kept in memory at most, the least recently used one is
+    // dropped when another one is cached (0 for no limit); ThermoDataSets loaded from files are always kept
+    int cacheMaxThermoDataSets = 0;
+    // seconds after which a downloaded ThermoDataSet is dropped, and downloaded again by the next request
+    // for it (0 keeps it until clearCachedThermoDataSets); ThermoDataSets loaded from files do not expire
+    int cacheTimeToLiveSeconds = 0;
+    // ThermoDataSets fetched and kept in memory by a background thread as soon as the options
+    // are set, so that the first requests for them are answered without querying the server
+    std::vector<std::string> prefetchThermoDataSets;
+    // properties of the substances and reactions to download, e.g. {"formula", "sm_gibbs_energy"}
+    // (all if empty); the symbol is always included
+    std::vector<std::string> selectedProperties;
+    // execution options of the ThermoDataSet queries
+    AqlQueryOptions aqlOptions;
+    // Unix domain socket of a cache daemon (thermohub-cache-daemon) serving the ThermoDataSets
+    // to all processes of the node; if set, subsets are requested from the daemon instead of the server
+    std::string cacheDaemonSocket;
+    // deadlines, retries and hedging of the queries to the server
+    RequestOptions requestOptions;
+    // threads selecting the substances and reactions by elements (1 selects in the calling thread,
+    // 0 uses all hardware threads)
+    int numThreads = 1;
+    // receive the ThermoDataSet query results as VelocyPack instead of JSON text, decoded into the
+    // ThermoDataSet without parsing text (the server must support the application/x-velocypack answers)
+    bool velocypackTransport = false;
+};
+
+/// Memory used by a request of DatabaseClient (get, save or columns functions)
+struct RequestMemoryStats
+{
+    // peak resident memory of the process after the request, in bytes
+    std::size_t peakResidentBytes = 0;
+    // increase of the peak resident memory of the process during the request, in bytes: the
+    // high-water mark of the whole process (all threads), so it is not the memory used by this
+    // request alone, and 0 if the process stayed below an earlier peak
+    std::size_t peakIncreaseBytes = 0;
 };
 
+/// A client can be shared by threads: its requests run one at a time, a thread waits for the
+/// request of another one to finish. Clients of their own run requests in parallel.
 class DatabaseClient
 {
 public:
+    /// Default (remote) connection, opened by the first request that needs the server
     DatabaseClient();
 
+    /// Connection from a configuration file, opened by the first request that needs the server
     DatabaseClient(const std::string &connection_configuration);
 
+    /// Construct with options, starts the background prefetch of options.prefetchThermoDataSets
+    DatabaseClient(const std::string &connection_configuration, const DatabaseClientOptions &options);
+
     /// Assign a DatabaseClient instance to this instance
     auto operator=(DatabaseClient other) -> DatabaseClient &;
 
@@ -53,9 +167,9 @@ public:
      * @brief Get the  Database
      * 
      * @param thermodataset symbol of ThermoDataSet available in ThermoHub server (local or remote)
-     * @return const std::string& JSON string {...} 
+     * @return DatabaseResult shared immutable JSON string {...} 
      */
-    auto getDatabase(const std::string &thermodataset) const -> const std::string &;
+    auto getDatabase(const std::string &thermodataset) const -> DatabaseResult;
 
     /**
      * @brief Get the Database Subset JSON string
@@ -65,21 +179,95 @@ public:
      * @param substances vector of substances symbols (optional)
      * @param classes vector of substances classes (optional)
      * @param aggregatestates vector of substances aggregate states (optional)
-     * @return const std::string& JSON string {...} 
+     * @return DatabaseResult shared immutable JSON string {...} 
      */
     auto getDatabaseSubset(const std::string &thermodataset, const std::vector<std::string> &elements = {},
                            const std::vector<std::string> &substances = {},
                            const std::vector<std::string> &classesOfSubstance = {},
-                           const std::vector<std::string> &aggregateStates = {}) const -> const std::string &;
+                           const std::vector<std::string> &aggregateStates = {}) const -> DatabaseResult;
 
     /**
      * @brief Get the Database object
      * 
      * @param thermodataset symbol of thermodataset from the database
      * @param elements list of elements to filter selected data
-     * @return const std::string& 
+     * @return DatabaseResult shared immutable JSON string {...} 
+     */
+    auto getDatabaseContainingElements(const std::string &thermodataset, const std::vector<std::string> &elements) const -> DatabaseResult;
+
+    /**
+     * @brief Get the thermodynamic properties of the Database (Subset) as columns
+     * 
+     * @param thermodataset symbol of ThermoDataSet available in ThermoHub server (local or remote)
+     * @param elements vector of elements symbols (optional)
+     * @param substances vector of substances symbols (optional)
+     * @param classes vector of substances classes (optional)
+     * @param aggregatestates vector of substances aggregate states (optional)
+     * @return ThermoDataColumns one row per substance and per reaction
      */
-    auto getDatabaseContainingElements(const std::string &thermodataset, const std::vector<std::string> &elements) const -> const std::string &;
+    auto getDatabaseColumns(const std::string &thermodataset, const std::vector<std::string> &elements = {},
+                            const std::vector<std::string> &substances = {},
+                            const std::vector<std::string> &classesOfSubstance = {},
+                            const std::vector<std::string> &aggregateStates = {}) const -> ThermoDataColumns;
+
+    /**
+     * @brief Get the formula matrix (elements x substances) of the Database (Subset)
+     *
+     * The matrix of a complete ThermoDataSet cached by the client (see DatabaseClientOptions::cacheThermoDataSets
+     * and loadThermoDataSet) is built once and kept with it. The substances must have their formula
+     * (in DatabaseClientOptions::selectedProperties if these are given).
+     * @param thermodataset symbol of ThermoDataSet available in ThermoHub server (local or remote)
+     * @param elements vector of elements symbols (optional)
+     * @param chargeRow add the charge as row Zz
+     * @return FormulaMatrix one row per element and one column per substance, in the order of the ThermoDataSet
+     */
+    auto getFormulaMatrix(const std::string &thermodataset, const std::vector<std::string> &elements = {},
+                          bool chargeRow = true) const -> FormulaMatrix;
+
+    /**
+     * @brief Get the reaction matrix (reactions x substances) of the reactant coefficients of the Database (Subset)
+     *
+     * @param thermodataset symbol of ThermoDataSet available in ThermoHub server (local or remote)
+     * @param elements vector of elements symbols (optional)
+     * @return ReactionMatrix one row per reaction and one column per substance, in the order of the ThermoDataSet
+     */
+    auto getReactionMatrix(const std::string &thermodataset, const std::vector<std::string> &elements = {}) const -> ReactionMatrix;
+
+    /**
+     * @brief Check the element and charge balance of all reactions of the Database (Subset)
+     *
+     * The substances must have their formula and the reactions their reactants (in
+     * DatabaseClientOptions::selectedProperties if these are given).
+     * @param thermodataset symbol of ThermoDataSet available in ThermoHub server (local or remote)
+     * @param elements vector of elements symbols (optional)
+     * @param tolerance relative tolerance of the balance residuals
+     * @return ReactionBalance the residuals of each reaction and element, with the unbalanced reactions
+     */
+    auto checkReactionBalance(const std::string &thermodataset, const std::vector<std::string> &elements = {},
+                              double tolerance = 1e-6) const -> ReactionBalance;
+
+    /**
+     * @brief Compute the molar mass and charge of all substances of the Database (Subset) from their formulas
+     *
+     * The computed values are compared to the mass_per_mole and formula_charge of the substances, which must
+     * have their formula (in DatabaseClientOptions::selectedProperties if these are given).
+     * @param thermodataset symbol of ThermoDataSet available in ThermoHub server (local or remote)
+     * @param elements vector of elements symbols (optional)
+     * @param tolerance relative tolerance of the comparison
+     * @return MolarMassCharge the computed and stored values of each substance, with the discrepancies
+     */
+    auto getMolarMassCharge(const std::string &thermodataset, const std::vector<std::string> &elements = {},
+                            double tolerance = 1e-4) const -> MolarMassCharge;
+
+    /**
+     * @brief Get the complete ThermoDataSet indexed for local subsets, with the reactions defining each substance
+     *
+     * The ThermoDataSet held by the client (see DatabaseClientOptions::cacheThermoDataSets and loadThermoDataSet)
+     * is returned, otherwise it is downloaded (and cached if cacheThermoDataSets is set).
+     * @param thermodataset symbol of ThermoDataSet available in ThermoHub server (local or remote)
+     * @return std::shared_ptr<const ThermoDataSetIndex> the complete ThermoDataSet and its indexes
+     */
+    auto getThermoDataSetIndex(const std::string &thermodataset) const -> std::shared_ptr<const ThermoDataSetIndex>;
 
     /**
      * @brief Save Database to json file (<thermodataset>-thermofun.json)
@@ -156,10 +344,64 @@ public:
      */
     auto reactionsInThermoDataSet(const std::string &thermodataset) -> std::vector<std::string>;
 
+    /**
+     * @brief Load a complete ThermoDataSet from a (compressed) database file saved with saveDatabase.
+     * All following requests for this ThermoDataSet are answered locally from the loaded data.
+     * 
+     * @param thermodataset symbol of the ThermoDataSet
+     * @param fileName name of the database file (.json, .json.gz or .json.zst)
+     */
+    auto loadThermoDataSet(const std::string &thermodataset, const std::string &fileName) -> void;
+
+    /**
+     * @brief Remove the ThermoDataSets held in memory (loaded or cached), the following requests query the server
+     */
+    auto clearCachedThermoDataSets() -> void;
+
+    /**
+     * @brief Peak resident memory of the process around the last get, save or columns request
+     * (process-wide figures, which include the memory of other threads)
+     */
+    auto lastRequestMemory() const -> RequestMemoryStats;
+
+    /**
+     * @brief Check if the background prefetch of the ThermoDataSets in DatabaseClientOptions::prefetchThermoDataSets is finished
+     */
+    auto isReady() const -> bool;
+
+    /**
+     * @brief Wait for the background prefetch of the ThermoDataSets in DatabaseClientOptions::prefetchThermoDataSets,
+     * throws the error of a failed prefetch
+     * 
+     * @param timeoutMilliseconds maximum waiting time, negative to wait until finished
+     * @return true if the prefetch is finished, false if the timeout expired
+     */
+    auto waitUntilReady(int timeoutMilliseconds = -1) const -> bool;
+
+    /**
+     * @brief Cancel the following get, save and columns requests with a CancelledError when the token is cancelled
+     *
+     * A cancelled request stops waiting for the server (the query finishes in the background on its own
+     * connection), stops parsing, filtering or writing, and releases its data; a partly written file is removed.
+     * @param token token cancelled e.g. by a user interface thread
+     */
+    auto setCancellationToken(const CancellationToken &token) -> void;
+
+    /**
+     * @brief Report the progress of the following get, save and columns requests
+     *
+     * @param callback called at each stage of a request and periodically while parsing and writing, in the thread
+     * running the request (an empty callback reports nothing)
+     */
+    auto setProgressCallback(const ProgressCallback &callback) -> void;
+
     /**
      * @brief set DatabaseClientOptions
      * 
-     * @param options json_indent_save, json_indent_get, filterCharge, databaseFileSuffix, subsetFileSuffix
+     * @param options json_indent_save, json_indent_get, filterCharge, databaseFileSuffix, subsetFileSuffix, fileCompression,
+     * cacheThermoDataSets, cacheMaxThermoDataSets, cacheTimeToLiveSeconds, prefetchThermoDataSets (starts the background prefetch),
+     * selectedProperties, aqlOptions, cacheDaemonSocket, requestOptions, numThreads,
+     * velocypackTransport
      */
     auto setOptions(const DatabaseClientOptions &options) -> void;
 
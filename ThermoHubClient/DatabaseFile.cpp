@@ -0,0 +1,536 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#include "DatabaseFile.h"
+#include "common/Exception.h"
+
+// C++ includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// compression libraries
+#include <zlib.h>
+#ifdef THERMOHUBCLIENT_USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace ThermoHubClient
+{
+
+// size of the uncompressed and compressed chunks
+const std::size_t file_buffer_size = 1 << 18;
+
+auto endsWith(const std::string &str, const std::string &suffix) -> bool
+{
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+auto compressionFromFileName(const std::string &fileName) -> FileCompression
+{
+    if (endsWith(fileName, ".gz"))
+        return FileCompression::Gzip;
+    if (endsWith(fileName, ".zst"))
+        return FileCompression::Zstd;
+    return FileCompression::Plain;
+}
+
+auto compressionSuffix(FileCompression compression) -> std::string
+{
+    switch (compression)
+    {
+    case FileCompression::Gzip:
+        return ".gz";
+    case FileCompression::Zstd:
+        return ".zst";
+    default:
+        return "";
+    }
+}
+
+auto checkCompressionSupported(FileCompression compression, const std::string &fileName) -> void
+{
+#ifndef THERMOHUBCLIENT_USE_ZSTD
+    hubErrorIf(compression == FileCompression::Zstd, "DatabaseFile",
+               "ThermoHubClient was built without zstd support, cannot process " + fileName, __LINE__, __FILE__);
+#else
+    (void)compression;
+    (void)fileName;
+#endif
+}
+
+// write the data of a file through to the disk
+auto syncFile(std::FILE *file) -> bool
+{
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return ::fsync(fileno(file)) == 0;
+#endif
+}
+
+// write the entries of the directory of fileName through to the disk, so that a renamed file survives a crash
+// (on Windows the rename itself is written through)
+auto syncDirectory(const std::string &fileName) -> bool
+{
+#ifdef _WIN32
+    (void)fileName;
+    return true;
+#else
+    auto slash = fileName.rfind('/');
+    auto directory = slash == std::string::npos ? std::string(".") : fileName.substr(0, std::max<std::size_t>(slash, 1));
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        return false;
+    // some file systems cannot sync directories
+    bool synced = ::fsync(fd) == 0 || errno == EINVAL;
+    ::close(fd);
+    return synced;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+
+struct CompressedFileBuffer::Impl
+{
+    std::string fileName;
+
+    FileCompression compression;
+
+    // written with stdio, whose descriptor is synced to the disk when the file is closed
+    std::FILE *file = nullptr;
+
+    // uncompressed data, used as the put area of the stream buffer
+    std::vector<char> input;
+
+    // compressed data
+    std::vector<char> output;
+
+    // first error that happened while writing
+    std::string error;
+
+    bool closed = false;
+
+    z_stream gzstream;
+#ifdef THERMOHUBCLIENT_USE_ZSTD
+    ZSTD_CStream *zstdstream = nullptr;
+#endif
+
+    Impl(const std::string &fileName_, FileCompression compression_)
+        : fileName(fileName_), compression(compression_), input(file_buffer_size)
+    {
+        checkCompressionSupported(compression, fileName);
+        file = std::fopen(fileName.c_str(), "wb");
+        hubErrorIf(file == nullptr, "DatabaseFile", "Cannot open file " + fileName + " for writing", __LINE__, __FILE__);
+
+        if (compression == FileCompression::Gzip)
+        {
+            output.resize(file_buffer_size);
+            gzstream = z_stream();
+            // 15 + 16: largest window with a gzip header and trailer
+            hubErrorIf(deflateInit2(&gzstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK,
+                       "DatabaseFile", "Cannot initialize gzip compression", __LINE__, __FILE__);
+        }
+#ifdef THERMOHUBCLIENT_USE_ZSTD
+        if (compression == FileCompression::Zstd)
+        {
+            output.resize(ZSTD_CStreamOutSize());
+            zstdstream = ZSTD_createCStream();
+            hubErrorIf(zstdstream == nullptr || ZSTD_isError(ZSTD_initCStream(zstdstream, ZSTD_CLEVEL_DEFAULT)),
+                       "DatabaseFile", "Cannot initialize zstd compression", __LINE__, __FILE__);
+        }
+#endif
+    }
+
+    ~Impl()
+    {
+        if (file)
+            std::fclose(file);
+        if (compression == FileCompression::Gzip)
+            deflateEnd(&gzstream);
+#ifdef THERMOHUBCLIENT_USE_ZSTD
+        if (zstdstream)
+            ZSTD_freeCStream(zstdstream);
+#endif
+    }
+
+    auto writeOutput(const char *data, std::size_t size) -> void
+    {
+        hubErrorIf(std::fwrite(data, 1, size, file) != size, "DatabaseFile", "Error writing file " + fileName, __LINE__, __FILE__);
+    }
+
+    // compress (or copy) a chunk of data to the file, finish the compressed stream if requested
+    auto write(const char *data, std::size_t size, bool finish) -> void
+    {
+        switch (compression)
+        {
+        case FileCompression::Gzip:
+        {
+            gzstream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+            gzstream.avail_in = static_cast<uInt>(size);
+            int ret = Z_OK;
+            do
+            {
+                gzstream.next_out = reinterpret_cast<Bytef *>(output.data());
+                gzstream.avail_out = static_cast<uInt>(output.size());
+                ret = deflate(&gzstream, finish ? Z_FINISH : Z_NO_FLUSH);
+                hubErrorIf(ret == Z_STREAM_ERROR, "DatabaseFile", "gzip compression error", __LINE__, __FILE__);
+                writeOutput(output.data(), output.size() - gzstream.avail_out);
+            } while (gzstream.avail_out == 0 || (finish && ret != Z_STREAM_END));
+            break;
+        }
+#ifdef THERMOHUBCLIENT_USE_ZSTD
+        case FileCompression::Zstd:
+        {
+            ZSTD_inBuffer in = {data, size, 0};
+            std::size_t remaining = 0;
+            do
+            {
+                ZSTD_outBuffer out = {output.data(), output.size(), 0};
+                remaining = ZSTD_compressStream2(zstdstream, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+                hubErrorIf(ZSTD_isError(remaining), "DatabaseFile",
+                           std::string("zstd compression error ") + ZSTD_getErrorName(remaining), __LINE__, __FILE__);
+                writeOutput(output.data(), out.pos);
+            } while (in.pos < in.size || (finish && remaining != 0));
+            break;
+        }
+#endif
+        default:
+            writeOutput(data, size);
+            break;
+        }
+    }
+};
+
+CompressedFileBuffer::CompressedFileBuffer(const std::string &fileName, FileCompression compression)
+    : pimpl(new Impl(fileName, compression))
+{
+    setp(pimpl->input.data(), pimpl->input.data() + pimpl->input.size());
+}
+
+CompressedFileBuffer::~CompressedFileBuffer()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+auto CompressedFileBuffer::overflow(int_type ch) -> int_type
+{
+    if (!pimpl->error.empty() || pimpl->closed)
+        return traits_type::eof();
+    try
+    {
+        pimpl->write(pbase(), static_cast<std::size_t>(pptr() - pbase()), false);
+        setp(pimpl->input.data(), pimpl->input.data() + pimpl->input.size());
+    }
+    catch (std::exception &e)
+    {
+        pimpl->error = e.what();
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+auto CompressedFileBuffer::xsputn(const char_type *s, std::streamsize count) -> std::streamsize
+{
+    // large blocks bypass the put area
+    if (count < static_cast<std::streamsize>(pimpl->input.size()))
+        return std::streambuf::xsputn(s, count);
+    if (sync() != 0)
+        return 0;
+    try
+    {
+        pimpl->write(s, static_cast<std::size_t>(count), false);
+    }
+    catch (std::exception &e)
+    {
+        pimpl->error = e.what();
+        return 0;
+    }
+    return count;
+}
+
+auto CompressedFileBuffer::sync() -> int
+{
+    return traits_type::eq_int_type(overflow(traits_type::eof()), traits_type::eof()) ? -1 : 0;
+}
+
+auto CompressedFileBuffer::close() -> void
+{
+    if (pimpl->closed)
+        return;
+    if (pimpl->error.empty())
+    {
+        try
+        {
+            pimpl->write(pbase(), static_cast<std::size_t>(pptr() - pbase()), true);
+        }
+        catch (std::exception &e)
+        {
+            pimpl->error = e.what();
+        }
+    }
+    setp(nullptr, nullptr);
+    pimpl->closed = true;
+    // the data must be on the disk before the file replaces an earlier one
+    if (pimpl->error.empty() && (std::fflush(pimpl->file) != 0 || !syncFile(pimpl->file)))
+        pimpl->error = "Error writing file " + pimpl->fileName;
+    if (std::fclose(pimpl->file) != 0 && pimpl->error.empty())
+        pimpl->error = "Error closing file " + pimpl->fileName;
+    pimpl->file = nullptr;
+    hubErrorIf(!pimpl->error.empty(), "DatabaseFile", pimpl->error, __LINE__, __FILE__);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+struct DecompressedFileBuffer::Impl
+{
+    std::string fileName;
+
+    FileCompression compression;
+
+    std::ifstream file;
+
+    // compressed data read from the file
+    std::vector<char> input;
+
+    // decompressed data, used as the get area of the stream buffer
+    std::vector<char> output;
+
+    // the last compressed stream (or frame) was completely decoded
+    bool complete = false;
+
+    z_stream gzstream;
+#ifdef THERMOHUBCLIENT_USE_ZSTD
+    ZSTD_DStream *zstdstream = nullptr;
+    ZSTD_inBuffer zstdin = {nullptr, 0, 0};
+#endif
+
+    Impl(const std::string &fileName_, FileCompression compression_)
+        : fileName(fileName_), compression(compression_), input(file_buffer_size)
+    {
+        checkCompressionSupported(compression, fileName);
+        file.open(fileName, std::ios::binary);
+        hubErrorIf(!file.is_open(), "DatabaseFile", "Cannot open file " + fileName + " for reading", __LINE__, __FILE__);
+
+        if (compression == FileCompression::Gzip)
+        {
+            output.resize(file_buffer_size);
+            gzstream = z_stream();
+            // 15 + 32: largest window, detect gzip or zlib header
+            hubErrorIf(inflateInit2(&gzstream, 15 + 32) != Z_OK,
+                       "DatabaseFile", "Cannot initialize gzip decompression", __LINE__, __FILE__);
+        }
+#ifdef THERMOHUBCLIENT_USE_ZSTD
+        if (compression == FileCompression::Zstd)
+        {
+            output.resize(ZSTD_DStreamOutSize());
+            zstdstream = ZSTD_createDStream();
+            hubErrorIf(zstdstream == nullptr || ZSTD_isError(ZSTD_initDStream(zstdstream)),
+                       "DatabaseFile", "Cannot initialize zstd decompression", __LINE__, __FILE__);
+        }
+#endif
+    }
+
+    ~Impl()
+    {
+        if (compression == FileCompression::Gzip)
+            inflateEnd(&gzstream);
+#ifdef THERMOHUBCLIENT_USE_ZSTD
+        if (zstdstream)
+            ZSTD_freeDStream(zstdstream);
+#endif
+    }
+
+    // read the next chunk of compressed data, returns the number of bytes read
+    auto readInput() -> std::size_t
+    {
+        file.read(input.data(), static_cast<std::streamsize>(input.size()));
+        hubErrorIf(file.bad(), "DatabaseFile", "Error reading file " + fileName, __LINE__, __FILE__);
+        return static_cast<std::size_t>(file.gcount());
+    }
+
+    // decompress the next chunk into the output buffer, returns the number of bytes available
+    auto read() -> std::size_t
+    {
+        switch (compression)
+        {
+        case FileCompression::Gzip:
+            while (true)
+            {
+                if (gzstream.avail_in == 0)
+                {
+                    gzstream.avail_in = static_cast<uInt>(readInput());
+                    gzstream.next_in = reinterpret_cast<Bytef *>(input.data());
+                    if (gzstream.avail_in == 0)
+                    {
+                        hubErrorIf(!complete, "DatabaseFile", "Unexpected end of gzip file " + fileName, __LINE__, __FILE__);
+                        return 0;
+                    }
+                }
+                gzstream.next_out = reinterpret_cast<Bytef *>(output.data());
+                gzstream.avail_out = static_cast<uInt>(output.size());
+                complete = false;
+                int ret = inflate(&gzstream, Z_NO_FLUSH);
+                if (ret == Z_STREAM_END)
+                {
+                    // a file can hold several concatenated gzip members
+                    complete = true;
+                    inflateReset(&gzstream);
+                }
+                else
+                    hubErrorIf(ret != Z_OK && ret != Z_BUF_ERROR, "DatabaseFile",
+                               "gzip decompression error in file " + fileName, __LINE__, __FILE__);
+                std::size_t produced = output.size() - gzstream.avail_out;
+                if (produced > 0)
+                    return produced;
+            }
+#ifdef THERMOHUBCLIENT_USE_ZSTD
+        case FileCompression::Zstd:
+            while (true)
+            {
+                if (zstdin.pos == zstdin.size)
+                {
+                    zstdin = {input.data(), readInput(), 0};
+                    if (zstdin.size == 0)
+                    {
+                        hubErrorIf(!complete, "DatabaseFile", "Unexpected end of zstd file " + fileName, __LINE__, __FILE__);
+                        return 0;
+                    }
+                }
+                ZSTD_outBuffer out = {output.data(), output.size(), 0};
+                std::size_t ret = ZSTD_decompressStream(zstdstream, &out, &zstdin);
+                hubErrorIf(ZSTD_isError(ret), "DatabaseFile",
+                           std::string("zstd decompression error ") + ZSTD_getErrorName(ret), __LINE__, __FILE__);
+                complete = (ret == 0);
+                if (out.pos > 0)
+                    return out.pos;
+            }
+#endif
+        default:
+            return 0;
+        }
+    }
+};
+
+DecompressedFileBuffer::DecompressedFileBuffer(const std::string &fileName, FileCompression compression)
+    : pimpl(new Impl(fileName, compression))
+{
+}
+
+DecompressedFileBuffer::~DecompressedFileBuffer()
+{
+}
+
+auto DecompressedFileBuffer::underflow() -> int_type
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    char *data = nullptr;
+    std::size_t size = 0;
+    if (pimpl->compression == FileCompression::Plain)
+    {
+        data = pimpl->input.data();
+        size = pimpl->readInput();
+    }
+    else
+    {
+        data = pimpl->output.data();
+        size = pimpl->read();
+    }
+    if (size == 0)
+        return traits_type::eof();
+    setg(data, data, data + size);
+    return traits_type::to_int_type(*gptr());
+}
+
+//-------------------------------------------------------------------------------------------------
+
+// unique name of a temporary file in the directory of fileName
+auto temporaryFileName(const std::string &fileName) -> std::string
+{
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return fileName + ".tmp" + std::to_string(stamp ^ static_cast<decltype(stamp)>(thread));
+}
+
+// replace fileName by the temporary file
+auto replaceFile(const std::string &temporaryName, const std::string &fileName) -> bool
+{
+#ifdef _WIN32
+    return MoveFileExA(temporaryName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(temporaryName.c_str(), fileName.c_str()) == 0;
+#endif
+}
+
+auto writeDatabaseFile(const std::string &fileName, const std::function<void(std::ostream &)> &write) -> void
+{
+    auto temporaryName = temporaryFileName(fileName);
+    try
+    {
+        CompressedFileBuffer buffer(temporaryName, compressionFromFileName(fileName));
+        std::ostream stream(&buffer);
+        write(stream);
+        stream.flush();
+        buffer.close();
+        hubErrorIf(!replaceFile(temporaryName, fileName), "DatabaseFile", "Cannot replace file " + fileName, __LINE__, __FILE__);
+        hubErrorIf(!syncDirectory(fileName), "DatabaseFile", "Cannot sync the directory of file " + fileName, __LINE__, __FILE__);
+    }
+    catch (...)
+    {
+        std::remove(temporaryName.c_str());
+        throw;
+    }
+}
+
+auto writeDatabaseFile(const std::string &fileName, const std::string &jsondata) -> void
+{
+    writeDatabaseFile(fileName, [&jsondata](std::ostream &stream) {
+        stream.write(jsondata.data(), static_cast<std::streamsize>(jsondata.size()));
+    });
+}
+
+auto readDatabaseFile(const std::string &fileName) -> std::string
+{
+    DecompressedFileBuffer buffer(fileName, compressionFromFileName(fileName));
+    return std::string(std::istreambuf_iterator<char>(&buffer), std::istreambuf_iterator<char>());
+}
+
+} // namespace ThermoHubClient
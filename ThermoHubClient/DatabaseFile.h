@@ -0,0 +1,109 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// C++ includes
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace ThermoHubClient
+{
+
+/// Compression of the saved database files
+enum class FileCompression
+{
+    Plain, ///< plain JSON text (.json)
+    Gzip,  ///< gzip compressed JSON text (.json.gz)
+    Zstd   ///< zstd compressed JSON text (.json.zst), if built with zstd
+};
+
+/// Compression of a database file deduced from its name (".gz" gzip, ".zst" zstd, otherwise none)
+auto compressionFromFileName(const std::string &fileName) -> FileCompression;
+
+/// File name extension added for a compression (".gz", ".zst" or empty)
+auto compressionSuffix(FileCompression compression) -> std::string;
+
+/// Output stream buffer that compresses the data while writing it to a file
+class CompressedFileBuffer : public std::streambuf
+{
+public:
+    CompressedFileBuffer(const std::string &fileName, FileCompression compression);
+
+    /// Closes the file, errors are only reported by close()
+    ~CompressedFileBuffer();
+
+    /// Finish the compressed stream and close the file, throws if anything failed while writing
+    auto close() -> void;
+
+protected:
+    auto overflow(int_type ch) -> int_type override;
+    auto xsputn(const char_type *s, std::streamsize count) -> std::streamsize override;
+    auto sync() -> int override;
+
+private:
+    struct Impl;
+
+    std::unique_ptr<Impl> pimpl;
+};
+
+/// Input stream buffer that decompresses the data while reading it from a file
+class DecompressedFileBuffer : public std::streambuf
+{
+public:
+    DecompressedFileBuffer(const std::string &fileName, FileCompression compression);
+
+    ~DecompressedFileBuffer();
+
+protected:
+    auto underflow() -> int_type override;
+
+private:
+    struct Impl;
+
+    std::unique_ptr<Impl> pimpl;
+};
+
+/**
+ * @brief Write a database file atomically, compressed as given by the file name suffix.
+ * The data is streamed into a temporary file next to fileName, which is synced to the disk and
+ * replaces fileName only after it was completely written, so readers never see a truncated file.
+ * The directory is synced after the rename, so the new file also survives a crash (POSIX).
+ *
+ * @param fileName name of the file (.json, .json.gz or .json.zst)
+ * @param write function writing the content to the (compressing) output stream
+ */
+auto writeDatabaseFile(const std::string &fileName, const std::function<void(std::ostream &)> &write) -> void;
+
+/**
+ * @brief Write a database JSON string to a file atomically, compressed as given by the file name suffix
+ *
+ * @param fileName name of the file (.json, .json.gz or .json.zst)
+ * @param jsondata database JSON string
+ */
+auto writeDatabaseFile(const std::string &fileName, const std::string &jsondata) -> void;
+
+/**
+ * @brief Read a database JSON string from a file, decompressed as given by the file name suffix
+ *
+ * @param fileName name of the file (.json, .json.gz or .json.zst)
+ * @return std::string database JSON string
+ */
+auto readDatabaseFile(const std::string &fileName) -> std::string;
+
+} // namespace ThermoHubClient
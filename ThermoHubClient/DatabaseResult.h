@@ -0,0 +1,125 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// C++ includes
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace ThermoHubClient
+{
+
+/// Immutable database JSON string returned by the DatabaseClient get functions.
+/// Copies share the same string, so a result is cheap to keep, to pass to other
+/// threads or to expose to Python, and it is never changed by later requests.
+/// A result may also view characters owned by something else, e.g. the shared memory
+/// mapping of a cache daemon answer, which is released with the last copy of the result.
+class DatabaseResult
+{
+public:
+    /// Empty result
+    DatabaseResult() : DatabaseResult(std::shared_ptr<const std::string>()) {}
+
+    /// Result holding a JSON string
+    explicit DatabaseResult(std::string jsondata_)
+        : DatabaseResult(std::make_shared<const std::string>(std::move(jsondata_)))
+    {
+    }
+
+    /// Result sharing a JSON string
+    explicit DatabaseResult(std::shared_ptr<const std::string> jsondata_)
+        : content(std::make_shared<Content>())
+    {
+        if (!jsondata_)
+            jsondata_ = std::make_shared<const std::string>();
+        content->first = jsondata_->data();
+        content->length = jsondata_->size();
+        content->jsondata = jsondata_;
+        content->owner = std::move(jsondata_);
+    }
+
+    /// Result viewing the size characters at data without copying them, owner keeps them valid
+    DatabaseResult(const char *data, std::size_t size, std::shared_ptr<const void> owner)
+        : content(std::make_shared<Content>())
+    {
+        content->first = data;
+        content->length = size;
+        content->owner = std::move(owner);
+    }
+
+    /// The JSON string (the viewed characters are copied into it by the first call)
+    auto str() const -> const std::string & { return *shared(); }
+
+    /// The JSON string, for code using the results as std::string; a reference to the string
+    /// of a temporary result is only valid while the result exists
+    operator const std::string &() const { return str(); }
+
+    /// The shared JSON string (the viewed characters are copied into it by the first call)
+    auto shared() const -> std::shared_ptr<const std::string>
+    {
+        std::call_once(content->copied, [this]() {
+            if (!content->jsondata)
+                content->jsondata = std::make_shared<const std::string>(content->first, content->length);
+        });
+        return content->jsondata;
+    }
+
+    /// The characters of the JSON string, never copied
+    auto data() const -> const char * { return content->first; }
+
+    /// Characters of the JSON string, e.g. for json::parse(result)
+    auto begin() const -> const char * { return content->first; }
+
+    auto end() const -> const char * { return content->first + content->length; }
+
+    auto size() const -> std::size_t { return content->length; }
+
+    auto empty() const -> bool { return content->length == 0; }
+
+private:
+    struct Content
+    {
+        const char *first = nullptr;
+        std::size_t length = 0;
+        // keeps the characters valid
+        std::shared_ptr<const void> owner;
+        // the characters as std::string, built once on demand for viewed characters
+        std::shared_ptr<const std::string> jsondata;
+        std::once_flag copied;
+    };
+
+    std::shared_ptr<Content> content;
+};
+
+inline auto operator<<(std::ostream &out, const DatabaseResult &result) -> std::ostream &
+{
+    return out << result.str();
+}
+
+inline auto operator==(const DatabaseResult &lhs, const std::string &rhs) -> bool
+{
+    return lhs.str() == rhs;
+}
+
+inline auto operator==(const std::string &lhs, const DatabaseResult &rhs) -> bool
+{
+    return lhs == rhs.str();
+}
+
+} // namespace ThermoHubClient
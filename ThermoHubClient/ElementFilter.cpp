@@ -0,0 +1,285 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "ElementFilter.h"
+#include "common/JsonView.h"
+#include "common/ThreadPool.h"
+#include "formulaparser/FormulaBatch.h"
+
+// C++ includes
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <unordered_set>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace ThermoHubClient
+{
+
+// remove the records not kept from a JSON array in place, moving the kept records forward in their order
+template <typename JsonType>
+static auto removeRecords(JsonType &records, const std::vector<char> &kept) -> void
+{
+    if (!records.is_array())
+        return;
+    auto &array = records.template get_ref<typename JsonType::array_t &>();
+    std::size_t last = 0;
+    for (std::size_t i = 0; i < array.size(); ++i)
+        if (kept[i])
+        {
+            if (i != last)
+                array[last] = std::move(array[i]);
+            ++last;
+        }
+    array.erase(array.begin() + static_cast<std::ptrdiff_t>(last), array.end());
+}
+
+// the records of a ThermoDataSet array, an empty array if there is none
+template <typename JsonType>
+static auto records(JsonType &thermodataset, const char *name) -> JsonType &
+{
+    auto &array = thermodataset[name];
+    if (!array.is_array())
+        array = JsonType::array();
+    return array;
+}
+
+// run body on the chunks of [0, count) on the thread pool, or at once in the calling thread without one
+static auto forChunks(std::size_t count, ThreadPool *pool, const std::function<void(std::size_t, std::size_t)> &body) -> void
+{
+    if (pool)
+        pool->parallelFor(count, std::max<std::size_t>(64, count / (8 * pool->size()) + 1), body);
+    else
+        body(0, count);
+}
+
+ElementFilter::ElementFilter(const std::vector<std::string> &elements, bool filterCharge)
+    : ids(FormulaParser::element_count)
+{
+    for (const auto &symbol : elements)
+    {
+        auto id = FormulaParser::elementId(symbol);
+        if (id != FormulaParser::no_element)
+            ids[id] = 1;
+        else
+            others.insert(symbol);
+    }
+    if (!filterCharge) // charge is considered by default if not filtered
+        ids[FormulaParser::charge_element] = 1;
+}
+
+auto ElementFilter::containsElement(const std::string &symbol) const -> bool
+{
+    auto id = FormulaParser::elementId(symbol);
+    return id != FormulaParser::no_element ? ids[id] : others.count(symbol) > 0;
+}
+
+auto ElementFilter::containsFormula(const FormulaParser::FormulaCompositions &compositions, std::size_t i) const -> bool
+{
+    if (!compositions.parsed(i))
+        throw std::runtime_error(compositions.errors[i]);
+    for (auto k = compositions.offsets[i]; k < compositions.offsets[i + 1]; ++k)
+    {
+        auto id = compositions.elementIds[k];
+        if (id < FormulaParser::element_count ? !ids[id] : !others.count(compositions.elementSymbols[id]))
+            return false;
+    }
+    return true;
+}
+
+// select the data of a ThermoDataSet of any JSON type in place
+template <typename JsonType>
+static auto selectRecords(const ElementFilter &filter, JsonType &thermodataset, const std::vector<char> &keepSubstances, ThreadPool *pool) -> void
+{
+    auto &elements = records(thermodataset, "elements");
+    std::vector<char> keepElements(elements.size());
+    for (std::size_t i = 0; i < elements.size(); ++i)
+        keepElements[i] = filter.containsElement(elements[i].value("symbol", ""));
+    removeRecords(elements, keepElements);
+
+    auto &substances = records(thermodataset, "substances");
+    if (keepSubstances.size() != substances.size())
+        throw std::runtime_error("ElementFilter: one flag per substance is needed.");
+    std::unordered_set<std::string> removed;
+    for (std::size_t i = 0; i < substances.size(); ++i)
+        if (!keepSubstances[i])
+            removed.insert(substances[i].value("symbol", ""));
+    removeRecords(substances, keepSubstances);
+
+    auto &reactions = records(thermodataset, "reactions");
+    std::vector<char> keepReactions(reactions.size(), 1);
+    // the reactions are only read while their flags are set in parallel
+    const JsonType &checked = reactions;
+    if (!removed.empty())
+        forChunks(checked.size(), pool, [&](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i)
+            {
+                auto reactants = checked[i].find("reactants");
+                if (reactants != checked[i].end() && reactants->is_array())
+                    for (const auto &reactant : *reactants)
+                        if (removed.count(reactant.value("symbol", "")))
+                        {
+                            keepReactions[i] = 0;
+                            break;
+                        }
+            }
+        });
+    removeRecords(reactions, keepReactions);
+}
+
+template <typename JsonType>
+static auto selectRecords(const ElementFilter &filter, JsonType &thermodataset, ThreadPool *pool) -> void
+{
+    const auto &substances = records(thermodataset, "substances");
+    std::vector<std::string> formulas(substances.size());
+    for (std::size_t i = 0; i < substances.size(); ++i)
+        formulas[i] = substances[i].value("formula", "");
+
+    const auto compositions = FormulaParser::parseMany(formulas, pool);
+    std::vector<char> keep(formulas.size());
+    forChunks(keep.size(), pool, [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i)
+            keep[i] = filter.containsFormula(compositions, i);
+    });
+    selectRecords(filter, thermodataset, keep, pool);
+}
+
+auto ElementFilter::select(json &thermodataset, const std::vector<char> &keepSubstances, ThreadPool *pool) const -> void
+{
+    selectRecords(*this, thermodataset, keepSubstances, pool);
+}
+
+auto ElementFilter::select(arena_json &thermodataset, const std::vector<char> &keepSubstances, ThreadPool *pool) const -> void
+{
+    selectRecords(*this, thermodataset, keepSubstances, pool);
+}
+
+auto ElementFilter::select(json &thermodataset, ThreadPool *pool) const -> void
+{
+    selectRecords(*this, thermodataset, pool);
+}
+
+auto ElementFilter::select(arena_json &thermodataset, ThreadPool *pool) const -> void
+{
+    selectRecords(*this, thermodataset, pool);
+}
+
+// append the records kept to out as a JSON array, with only the properties (if any) of each record
+static auto appendRecords(std::string &out, const std::vector<JsonView> &records, const std::vector<char> &kept,
+                          const std::set<std::string> &properties) -> void
+{
+    out += '[';
+    bool first = true;
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        if (!kept[i])
+            continue;
+        if (!first)
+            out += ',';
+        first = false;
+        if (properties.empty() || !records[i].isObject())
+        {
+            records[i].appendTo(out);
+            continue;
+        }
+        out += '{';
+        bool firstMember = true;
+        for (const auto &member : records[i].members())
+            if (properties.count(member.first))
+            {
+                if (!firstMember)
+                    out += ',';
+                firstMember = false;
+                JsonView::appendString(out, member.first);
+                out += ':';
+                member.second.appendTo(out);
+            }
+        out += '}';
+    }
+    out += ']';
+}
+
+auto ElementFilter::selectText(const JsonView &thermodataset, const std::set<std::string> &properties, ThreadPool *pool) const -> std::string
+{
+    // the members of the ThermoDataSet in key order, with the three record arrays select() always leaves
+    auto members = thermodataset.members();
+    for (const auto &name : {"elements", "reactions", "substances"})
+        if (std::none_of(members.begin(), members.end(), [&](const std::pair<std::string, JsonView> &member) { return member.first == name; }))
+            members.emplace_back(name, JsonView());
+    std::sort(members.begin(), members.end(), [](const std::pair<std::string, JsonView> &a, const std::pair<std::string, JsonView> &b) {
+        return a.first < b.first;
+    });
+    auto records = [&members](const char *name) {
+        return std::find_if(members.begin(), members.end(), [&](const std::pair<std::string, JsonView> &member) { return member.first == name; })->second.elements();
+    };
+
+    const auto elements = records("elements");
+    std::vector<char> keepElements(elements.size());
+    for (std::size_t i = 0; i < elements.size(); ++i)
+        keepElements[i] = containsElement(elements[i].find("symbol").stringValue());
+
+    const auto substances = records("substances");
+    std::vector<std::string> formulas(substances.size());
+    for (std::size_t i = 0; i < substances.size(); ++i)
+        formulas[i] = substances[i].find("formula").stringValue();
+    const auto compositions = FormulaParser::parseMany(formulas, pool);
+    std::vector<char> keepSubstances(formulas.size());
+    forChunks(keepSubstances.size(), pool, [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i)
+            keepSubstances[i] = containsFormula(compositions, i);
+    });
+    std::unordered_set<std::string> removed;
+    for (std::size_t i = 0; i < substances.size(); ++i)
+        if (!keepSubstances[i])
+            removed.insert(substances[i].find("symbol").stringValue());
+
+    const auto reactions = records("reactions");
+    std::vector<char> keepReactions(reactions.size(), 1);
+    if (!removed.empty())
+        forChunks(reactions.size(), pool, [&](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i)
+                for (const auto &reactant : reactions[i].find("reactants").elements())
+                    if (removed.count(reactant.find("symbol").stringValue()))
+                    {
+                        keepReactions[i] = 0;
+                        break;
+                    }
+        });
+
+    std::string out = "{";
+    for (const auto &member : members)
+    {
+        if (out.size() > 1)
+            out += ',';
+        JsonView::appendString(out, member.first);
+        out += ':';
+        if (member.first == "elements")
+            appendRecords(out, elements, keepElements, {});
+        else if (member.first == "substances")
+            appendRecords(out, substances, keepSubstances, properties);
+        else if (member.first == "reactions")
+            appendRecords(out, reactions, keepReactions, properties);
+        else
+            member.second.appendTo(out);
+    }
+    out += '}';
+    return out;
+}
+
+} // namespace ThermoHubClient
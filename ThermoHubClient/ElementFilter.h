@@ -0,0 +1,78 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "common/Arena.h"
+
+// C++ includes
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json_fwd.hpp>
+
+namespace FormulaParser {
+struct FormulaCompositions;
+}
+
+namespace ThermoHubClient
+{
+
+class JsonView;
+class ThreadPool;
+
+/// Selection of the data of a ThermoDataSet containing a list of elements: the elements of the list,
+/// the substances with only these elements in their formulas, and the reactions without removed
+/// substances among their reactants. The server query results of DatabaseClient, the cached
+/// ThermoDataSets of ThermoDataSetIndex and the cache daemon are all selected by this filter.
+class ElementFilter
+{
+public:
+    /// Filter of the element symbols, with the charge Zz unless filterCharge
+    ElementFilter(const std::vector<std::string> &elements, bool filterCharge);
+
+    /// Check if an element symbol is selected
+    auto containsElement(const std::string &symbol) const -> bool;
+
+    /// Check if formula i of the compositions has only selected elements, throws the parser error of a failed formula
+    auto containsFormula(const FormulaParser::FormulaCompositions &compositions, std::size_t i) const -> bool;
+
+    /// Select the data in place, keepSubstances flags the substances to keep in the order of the ThermoDataSet;
+    /// the reactants of the reactions are checked on the thread pool (if any)
+    auto select(nlohmann::json &thermodataset, const std::vector<char> &keepSubstances, ThreadPool *pool = nullptr) const -> void;
+
+    /// Select the data of a request arena document in place, as above
+    auto select(arena_json &thermodataset, const std::vector<char> &keepSubstances, ThreadPool *pool = nullptr) const -> void;
+
+    /// Select the data in place, the formulas are parsed and the reactants checked on the thread pool (if any)
+    auto select(nlohmann::json &thermodataset, ThreadPool *pool = nullptr) const -> void;
+
+    /// Select the data of a request arena document in place, as above
+    auto select(arena_json &thermodataset, ThreadPool *pool = nullptr) const -> void;
+
+    /// Select the data of a ThermoDataSet in the text of a query result, no DOM is built; the result is the text of
+    /// select() and dump() of the parsed ThermoDataSet, with only the substance and reaction properties (if any)
+    auto selectText(const JsonView &thermodataset, const std::set<std::string> &properties, ThreadPool *pool = nullptr) const -> std::string;
+
+private:
+    // selected element ids of the periodic table, and the selected symbols out of it
+    std::vector<char> ids;
+    std::set<std::string> others;
+};
+
+} // namespace ThermoHubClient
@@ -0,0 +1,148 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "FormulaMatrix.h"
+#include "formulaparser/FormulaBatch.h"
+
+// C++ includes
+#include <algorithm>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace ThermoHubClient
+{
+
+// symbols of the records of a ThermoDataSet array
+static auto recordSymbols(const json &thermodataset, const std::string &name) -> std::vector<std::string>
+{
+    std::vector<std::string> symbols;
+    auto itr = thermodataset.find(name);
+    if (itr != thermodataset.end() && itr->is_array())
+        for (const auto &record : *itr)
+            symbols.push_back(record.value("symbol", ""));
+    return symbols;
+}
+
+auto formulaMatrix(const json &thermodataset, bool chargeRow, ThreadPool *pool) -> FormulaMatrix
+{
+    if (!thermodataset.is_object())
+        throw std::runtime_error("FormulaMatrix: the ThermoDataSet must be a JSON object.");
+
+    std::vector<std::string> formulas;
+    auto substances = thermodataset.find("substances");
+    if (substances != thermodataset.end() && substances->is_array())
+        for (const auto &substance : *substances)
+            formulas.push_back(substance.value("formula", ""));
+
+    return formulaMatrix(recordSymbols(thermodataset, "elements"), recordSymbols(thermodataset, "substances"),
+                         FormulaParser::parseMany(formulas, pool), chargeRow);
+}
+
+auto formulaMatrix(const std::vector<std::string> &elements, const std::vector<std::string> &substances,
+                   const FormulaParser::FormulaCompositions &compositions, bool chargeRow) -> FormulaMatrix
+{
+    if (compositions.size() != substances.size())
+        throw std::runtime_error("FormulaMatrix: one formula composition per substance is needed.");
+
+    FormulaMatrix matrix;
+    matrix.substances = substances;
+
+    // row of each element id of the compositions, -1 if the element is not a row
+    const int no_row = -1;
+    const auto &symbols = compositions.elementSymbols;
+    std::vector<int> rowOfId(symbols.size(), no_row);
+    for (const auto &symbol : elements)
+    {
+        if (symbol == "Zz" && !chargeRow)
+            continue;
+        // an element listed twice keeps an empty row, the rows stay aligned with the elements
+        auto id = static_cast<std::size_t>(std::find(symbols.begin(), symbols.end(), symbol) - symbols.begin());
+        if (id < symbols.size() && rowOfId[id] == no_row)
+            rowOfId[id] = static_cast<int>(matrix.elements.size());
+        matrix.elements.push_back(symbol);
+    }
+    const auto charge = static_cast<std::size_t>(FormulaParser::charge_element);
+    if (chargeRow && charge < symbols.size() && rowOfId[charge] == no_row)
+    {
+        rowOfId[charge] = static_cast<int>(matrix.elements.size());
+        matrix.elements.push_back("Zz");
+    }
+
+    // the entries of a substance are in element order, the valences of an element are adjacent and summed
+    auto forEachEntry = [&compositions](std::size_t substance, auto entry) {
+        const auto end = compositions.offsets[substance + 1];
+        for (auto k = compositions.offsets[substance]; k < end;)
+        {
+            const auto id = compositions.elementIds[k];
+            double stoich = 0.;
+            for (; k < end && compositions.elementIds[k] == id; ++k)
+                stoich += compositions.stoichiometries[k];
+            entry(id, stoich);
+        }
+    };
+
+    // the columns of the formulas that failed to parse or have an element that is not a row stay empty
+    std::vector<char> failed(substances.size(), 0);
+    auto fail = [&](std::size_t j, const std::string &reason) {
+        failed[j] = 1;
+        matrix.failedColumns.push_back(j);
+        matrix.failures.push_back(reason);
+    };
+
+    // count the entries of each row, then fill the rows in substance (column) order
+    std::vector<std::size_t> counts(matrix.rows() + 1, 0);
+    for (std::size_t j = 0; j < substances.size(); ++j)
+    {
+        if (!compositions.parsed(j))
+        {
+            fail(j, "FormulaMatrix: substance " + substances[j] + ": " + compositions.errors[j]);
+            continue;
+        }
+        forEachEntry(j, [&](int id, double) {
+            // the charge is left out without charge row
+            if (rowOfId[id] == no_row && id != FormulaParser::charge_element && !failed[j])
+                fail(j, "FormulaMatrix: element " + symbols[id] + " of substance " + substances[j] +
+                            " is not an element of the ThermoDataSet.");
+        });
+        if (failed[j])
+            continue;
+        forEachEntry(j, [&](int id, double) {
+            if (rowOfId[id] != no_row)
+                ++counts[rowOfId[id] + 1];
+        });
+    }
+    for (std::size_t i = 0; i < matrix.rows(); ++i)
+        counts[i + 1] += counts[i];
+    matrix.rowOffsets = counts;
+
+    matrix.columns.resize(counts.back());
+    matrix.values.resize(counts.back());
+    for (std::size_t j = 0; j < substances.size(); ++j)
+        if (!failed[j])
+            forEachEntry(j, [&](int id, double stoich) {
+                if (rowOfId[id] == no_row)
+                    return;
+                auto k = counts[rowOfId[id]]++;
+                matrix.columns[k] = j;
+                matrix.values[k] = stoich;
+            });
+    return matrix;
+}
+
+} // namespace ThermoHubClient
@@ -0,0 +1,78 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "CsrMatrix.h"
+
+// C++ includes
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json_fwd.hpp>
+
+namespace FormulaParser {
+struct FormulaCompositions;
+}
+
+namespace ThermoHubClient
+{
+
+class ThreadPool;
+
+/// Element by substance stoichiometry matrix of a ThermoDataSet (the formula matrix), with the entries
+/// of each row in column order.
+/// The elements of all valences of a formula are summed, the charge is the row of the element Zz.
+struct FormulaMatrix : CsrMatrix
+{
+    /// element symbols, one per row (in the order of the ThermoDataSet, Zz last if it is not an element of it)
+    std::vector<std::string> elements;
+    /// substance symbols, one per column (in the order of the ThermoDataSet)
+    std::vector<std::string> substances;
+
+    /// columns of the substances whose formula could not be parsed or has an element that is not a row,
+    /// left empty
+    std::vector<std::size_t> failedColumns;
+    /// reason of each failed column
+    std::vector<std::string> failures;
+
+    auto rows() const -> std::size_t { return elements.size(); }
+
+    auto cols() const -> std::size_t { return substances.size(); }
+
+    /// The row-major dense matrix (rows() x cols())
+    auto dense() const -> std::vector<double> { return CsrMatrix::dense(cols()); }
+};
+
+/**
+ * @brief Build the formula matrix of a ThermoDataSet
+ *
+ * A substance whose formula cannot be parsed, or has an element that is not an element of the
+ * ThermoDataSet, gets an empty column listed in failedColumns with the reason in failures.
+ * @param thermodataset ThermoDataSet with its elements and the formulas of its substances
+ * @param chargeRow add the charge as row Zz, otherwise the charge of the formulas is left out
+ * @param pool thread pool parsing the formulas in parallel (optional)
+ * @return FormulaMatrix the elements of the ThermoDataSet by its substances
+ */
+auto formulaMatrix(const nlohmann::json &thermodataset, bool chargeRow = true, ThreadPool *pool = nullptr) -> FormulaMatrix;
+
+/// Build the formula matrix of the element and substance symbols from the compositions of
+/// the substance formulas already parsed (one per substance)
+auto formulaMatrix(const std::vector<std::string> &elements, const std::vector<std::string> &substances,
+                   const FormulaParser::FormulaCompositions &compositions, bool chargeRow = true) -> FormulaMatrix;
+
+} // namespace ThermoHubClient
@@ -0,0 +1,134 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "MolarMassCharge.h"
+#include "formulaparser/FormulaBatch.h"
+
+// C++ includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace ThermoHubClient
+{
+
+const double no_value = std::numeric_limits<double>::quiet_NaN();
+
+// a number, or the first of its "values" as in {"values": [40.078]}, NaN if none
+static auto numberValue(const json &record, const std::string &property) -> double
+{
+    auto itp = record.find(property);
+    if (itp == record.end())
+        return no_value;
+    if (itp->is_number())
+        return itp->get<double>();
+    if (!itp->is_object())
+        return no_value;
+    auto itv = itp->find("values");
+    if (itv == itp->end() || !itv->is_array() || itv->empty() || !itv->front().is_number())
+        return no_value;
+    return itv->front().get<double>();
+}
+
+static auto records(const json &thermodataset, const std::string &name) -> const json &
+{
+    static const json none = json::array();
+    auto itr = thermodataset.find(name);
+    return itr != thermodataset.end() && itr->is_array() ? *itr : none;
+}
+
+auto molarMassCharge(const json &thermodataset, double tolerance, ThreadPool *pool) -> MolarMassCharge
+{
+    if (!thermodataset.is_object())
+        throw std::runtime_error("MolarMassCharge: the ThermoDataSet must be a JSON object.");
+    std::vector<std::string> formulas;
+    for (const auto &substance : records(thermodataset, "substances"))
+        formulas.push_back(substance.value("formula", ""));
+    return molarMassCharge(thermodataset, FormulaParser::parseMany(formulas, pool), tolerance);
+}
+
+auto molarMassCharge(const json &thermodataset, const FormulaParser::FormulaCompositions &compositions,
+                     double tolerance) -> MolarMassCharge
+{
+    if (!thermodataset.is_object())
+        throw std::runtime_error("MolarMassCharge: the ThermoDataSet must be a JSON object.");
+    const auto &substances = records(thermodataset, "substances");
+    if (compositions.size() != substances.size())
+        throw std::runtime_error("MolarMassCharge: one formula composition per substance is needed.");
+
+    // atomic mass and charge of each element id: an element without atomic_mass gives NaN masses,
+    // the charge Zz has no mass
+    const auto &symbols = compositions.elementSymbols;
+    std::vector<double> massOfId(symbols.size(), no_value);
+    std::vector<double> chargeOfId(symbols.size(), 0.);
+    for (const auto &element : records(thermodataset, "elements"))
+    {
+        auto itr = std::find(symbols.begin(), symbols.end(), element.value("symbol", ""));
+        if (itr != symbols.end())
+            massOfId[itr - symbols.begin()] = numberValue(element, "atomic_mass");
+    }
+    massOfId[FormulaParser::charge_element] = 0.;
+    chargeOfId[FormulaParser::charge_element] = 1.;
+
+    MolarMassCharge result;
+    const auto count = substances.size();
+    result.substances.reserve(count);
+    result.storedMolarMasses.reserve(count);
+    result.storedCharges.reserve(count);
+    for (const auto &substance : substances)
+    {
+        result.substances.push_back(substance.value("symbol", ""));
+        result.storedMolarMasses.push_back(numberValue(substance, "mass_per_mole"));
+        result.storedCharges.push_back(numberValue(substance, "formula_charge"));
+    }
+
+    // one pass over the entries of all formulas, without branches on the elements
+    result.molarMasses.resize(count);
+    result.charges.resize(count);
+    const auto *ids = compositions.elementIds.data();
+    const auto *stoich = compositions.stoichiometries.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        double mass = 0.;
+        double charge = 0.;
+        for (auto k = compositions.offsets[i]; k < compositions.offsets[i + 1]; ++k)
+        {
+            mass += massOfId[ids[k]] * stoich[k];
+            charge += chargeOfId[ids[k]] * stoich[k];
+        }
+        result.molarMasses[i] = compositions.parsed(i) ? mass : no_value;
+        result.charges[i] = compositions.parsed(i) ? charge : no_value;
+    }
+
+    auto differs = [tolerance](double computed, double stored) {
+        return !std::isnan(stored) && !(std::abs(computed - stored) <= tolerance * std::max(1., std::abs(stored)));
+    };
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (differs(result.molarMasses[i], result.storedMolarMasses[i]))
+            result.massDiscrepancies.push_back(i);
+        if (differs(result.charges[i], result.storedCharges[i]))
+            result.chargeDiscrepancies.push_back(i);
+    }
+    return result;
+}
+
+} // namespace ThermoHubClient
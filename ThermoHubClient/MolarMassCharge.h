@@ -0,0 +1,75 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+// C++ includes
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json_fwd.hpp>
+
+namespace FormulaParser {
+struct FormulaCompositions;
+}
+
+namespace ThermoHubClient
+{
+
+class ThreadPool;
+
+/// Molar mass and charge of the substances of a ThermoDataSet computed from their formulas and the
+/// atomic_mass of the elements, next to the stored mass_per_mole and formula_charge.
+/// A computed value is NaN if the formula is not parsed or an element has no atomic_mass, a stored value if it is missing.
+struct MolarMassCharge
+{
+    /// substance symbols (in the order of the ThermoDataSet)
+    std::vector<std::string> substances;
+
+    /// molar mass computed from the formula of each substance
+    std::vector<double> molarMasses;
+    /// charge computed from the formula of each substance
+    std::vector<double> charges;
+
+    /// mass_per_mole of each substance
+    std::vector<double> storedMolarMasses;
+    /// formula_charge of each substance
+    std::vector<double> storedCharges;
+
+    /// positions of the substances with a stored molar mass different from the computed one
+    std::vector<std::size_t> massDiscrepancies;
+    /// positions of the substances with a stored charge different from the computed one
+    std::vector<std::size_t> chargeDiscrepancies;
+};
+
+/**
+ * @brief Compute the molar mass and charge of all substances of a ThermoDataSet and compare them to the stored values
+ *
+ * A stored value differs when it is further than tolerance times its magnitude (at least tolerance)
+ * from the computed one, or when the computed value is NaN.
+ * @param thermodataset ThermoDataSet with its elements and substances
+ * @param tolerance relative tolerance of the comparison
+ * @param pool thread pool parsing the formulas in parallel (optional)
+ */
+auto molarMassCharge(const nlohmann::json &thermodataset, double tolerance = 1e-4, ThreadPool *pool = nullptr) -> MolarMassCharge;
+
+/// Compute the molar mass and charge of the substances of a ThermoDataSet from the compositions of
+/// their formulas already parsed (one per substance)
+auto molarMassCharge(const nlohmann::json &thermodataset, const FormulaParser::FormulaCompositions &compositions,
+                     double tolerance = 1e-4) -> MolarMassCharge;
+
+} // namespace ThermoHubClient
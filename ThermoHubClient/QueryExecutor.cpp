@@ -0,0 +1,420 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#include "QueryExecutor.h"
+#include "VelocyPackCursor.h"
+
+// C++ includes
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+namespace ThermoHubClient
+{
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+// interval at which a query or a backoff waiting for a result checks its cancellation token
+const auto cancellationInterval = std::chrono::milliseconds(20);
+
+// result of the attempts of one query (the first attempt and its hedge)
+struct Attempts
+{
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    // set by the first successful attempt, by the last failed one, or by the timeout
+    bool done = false;
+
+    // attempts still running
+    int running = 0;
+
+    std::vector<std::string> values;
+    std::exception_ptr error;
+};
+
+// HTTP status code and ArangoDB error number of the error document the server answered with
+struct ServerError
+{
+    int code = 0;
+    int errorNum = 0;
+};
+
+// the error document of the server in the message of an arango_exception, none if the request
+// failed before the server answered (jsonarango passes the codes only in the message)
+auto serverError(const std::string &message, ServerError &error) -> bool
+{
+    const auto last = message.rfind('}');
+    for (auto first = message.find('{'); first != std::string::npos && first < last; first = message.find('{', first + 1))
+    {
+        auto document = nlohmann::json::parse(message.begin() + static_cast<std::ptrdiff_t>(first),
+                                              message.begin() + static_cast<std::ptrdiff_t>(last) + 1, nullptr, false);
+        if (!document.is_object())
+            continue;
+        auto code = document.find("code");
+        auto errorNum = document.find("errorNum");
+        if (code == document.end() && errorNum == document.end())
+            continue;
+        error.code = code != document.end() && code->is_number_integer() ? code->get<int>() : 0;
+        error.errorNum = errorNum != document.end() && errorNum->is_number_integer() ? errorNum->get<int>() : 0;
+        return true;
+    }
+    return false;
+}
+
+// server overload and unavailability, worth another attempt
+auto isTransient(const ServerError &error) -> bool
+{
+    // request timeout, too many requests, bad gateway, service unavailable, gateway timeout
+    for (auto code : {408, 429, 502, 503, 504})
+        if (error.code == code)
+            return true;
+    // lock timeout, queue full, shutting down, cluster timeout, cluster backend unavailable
+    for (auto errorNum : {18, 21, 30, 1457, 1478})
+        if (error.errorNum == errorNum)
+            return true;
+    return false;
+}
+
+// random delay up to the exponential backoff of the retry (full jitter)
+auto backoffDelay(const RequestOptions &options, int retry) -> std::chrono::milliseconds
+{
+    thread_local std::mt19937 generator{std::random_device{}()};
+    double limit = std::max(options.backoffMilliseconds, 0);
+    for (int i = 0; i < retry && limit < options.maxBackoffMilliseconds; ++i)
+        limit *= 2;
+    limit = std::min<double>(limit, std::max(options.maxBackoffMilliseconds, 0));
+    std::uniform_real_distribution<double> delay(0., limit);
+    return std::chrono::milliseconds(static_cast<long long>(delay(generator)));
+}
+
+// sleep for the delay, in short steps when the request can be cancelled
+auto sleepUnlessCancelled(std::chrono::milliseconds delay, const CancellationToken *cancellation) -> void
+{
+    if (!cancellation)
+    {
+        std::this_thread::sleep_for(delay);
+        return;
+    }
+    for (auto end = clock::now() + delay; clock::now() < end;)
+    {
+        cancellation->throwIfCancelled();
+        std::this_thread::sleep_for(std::min<clock::duration>(cancellationInterval, end - clock::now()));
+    }
+    cancellation->throwIfCancelled();
+}
+
+auto elapsedMilliseconds(clock::time_point start) -> long long
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+}
+
+// the JSON documents selected by the query on the connection
+auto selectQuery(arangocpp::ArangoDBCollectionAPI &db, const std::string &collection,
+                 const arangocpp::ArangoDBQuery &query) -> std::vector<std::string>
+{
+    std::vector<std::string> values;
+    try
+    {
+        db.selectQuery(collection, query, [&values](const std::string &jsondata) {
+            values.push_back(jsondata);
+        });
+    }
+    catch (arangocpp::arango_exception &e)
+    {
+        std::rethrow_exception(QueryExecutor::translate(e));
+    }
+    return values;
+}
+
+} // namespace
+
+// connections of the attempts running in their own threads, shared with these threads so that
+// an attempt left behind by a timeout can still return its connection
+struct QueryExecutor::ConnectionPool
+{
+    arangocpp::ArangoDBConnection connectionData;
+
+    std::mutex mutex;
+
+    std::vector<std::unique_ptr<arangocpp::ArangoDBCollectionAPI>> idle;
+
+    std::vector<std::unique_ptr<VelocyPackCursor>> idleCursors;
+
+    // attempts running in their own threads, including those left behind by a timeout or a cancellation
+    int inFlight = 0;
+
+    std::condition_variable attemptFinished;
+
+    explicit ConnectionPool(const arangocpp::ArangoDBConnection &connectionData_) : connectionData(connectionData_) {}
+
+    auto acquire() -> std::unique_ptr<arangocpp::ArangoDBCollectionAPI>
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idle.empty())
+            {
+                auto db = std::move(idle.back());
+                idle.pop_back();
+                return db;
+            }
+        }
+        return std::unique_ptr<arangocpp::ArangoDBCollectionAPI>(new arangocpp::ArangoDBCollectionAPI(connectionData));
+    }
+
+    // only connections of successful queries are reused
+    auto release(std::unique_ptr<arangocpp::ArangoDBCollectionAPI> db) -> void
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(std::move(db));
+    }
+
+    auto acquireCursor() -> std::unique_ptr<VelocyPackCursor>
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!idleCursors.empty())
+            {
+                auto cursor = std::move(idleCursors.back());
+                idleCursors.pop_back();
+                return cursor;
+            }
+        }
+        return std::unique_ptr<VelocyPackCursor>(new VelocyPackCursor(connectionData));
+    }
+
+    auto releaseCursor(std::unique_ptr<VelocyPackCursor> cursor) -> void
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        idleCursors.push_back(std::move(cursor));
+    }
+
+    // take a place for an attempt, waiting for one until the deadline while limit attempts are in flight
+    auto startAttempt(int limit, clock::time_point deadline, const CancellationToken *cancellation) -> bool
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (limit > 0 && inFlight >= limit)
+        {
+            if (cancellation)
+                cancellation->throwIfCancelled();
+            auto now = clock::now();
+            if (now >= deadline)
+                return false;
+            attemptFinished.wait_until(lock, cancellation ? std::min(deadline, now + cancellationInterval) : deadline);
+        }
+        ++inFlight;
+        return true;
+    }
+
+    auto finishAttempt() -> void
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --inFlight;
+        }
+        attemptFinished.notify_all();
+    }
+};
+
+QueryExecutor::QueryExecutor(const arangocpp::ArangoDBConnection &connection)
+    : pool(std::make_shared<ConnectionPool>(connection))
+{
+}
+
+auto QueryExecutor::translate(const arangocpp::arango_exception &e) -> std::exception_ptr
+{
+    std::stringstream buffer;
+    buffer << "ThermoHubClient" << e.header() << std::endl
+           << e.what() << std::endl;
+    // a request the server did not answer failed in the connection
+    ServerError error;
+    if (!serverError(e.what(), error))
+        return std::make_exception_ptr(TransientError(buffer.str()));
+    return translate(error.code, error.errorNum, buffer.str());
+}
+
+auto QueryExecutor::translate(int code, int errorNum, const std::string &message) -> std::exception_ptr
+{
+    if (isTransient(ServerError{code, errorNum}))
+        return std::make_exception_ptr(TransientError(message));
+    return std::make_exception_ptr(std::runtime_error(message));
+}
+
+auto QueryExecutor::select(arangocpp::ArangoDBCollectionAPI &db, const std::string &collection,
+                           const arangocpp::ArangoDBQuery &query, const RequestOptions &options,
+                           const CancellationToken *cancellation) -> std::vector<std::string>
+{
+    auto direct = [&]() { return selectQuery(db, collection, query); };
+    auto attempt = [collection, query](ConnectionPool &connections) {
+        auto connection = connections.acquire();
+        auto values = selectQuery(*connection, collection, query);
+        connections.release(std::move(connection));
+        return values;
+    };
+    return run(direct, attempt, options, cancellation);
+}
+
+auto QueryExecutor::selectVelocyPack(const std::string &query, const std::string &bindVars, const std::string &queryOptions,
+                                     const RequestOptions &options, const CancellationToken *cancellation) -> std::vector<std::string>
+{
+    auto attempt = [query, bindVars, queryOptions](ConnectionPool &connections) {
+        auto cursor = connections.acquireCursor();
+        auto values = cursor->select(query, bindVars, queryOptions);
+        connections.releaseCursor(std::move(cursor));
+        return values;
+    };
+    auto connections = pool;
+    auto direct = [&]() { return attempt(*connections); };
+    return run(direct, attempt, options, cancellation);
+}
+
+auto QueryExecutor::run(const std::function<std::vector<std::string>()> &direct, const Attempt &attempt,
+                        const RequestOptions &options, const CancellationToken *cancellation) -> std::vector<std::string>
+{
+    const auto start = clock::now();
+    const bool limited = options.totalTimeoutMilliseconds > 0;
+    const auto end = limited ? start + std::chrono::milliseconds(options.totalTimeoutMilliseconds) : clock::time_point::max();
+
+    for (int retry = 0;; ++retry)
+    {
+        if (cancellation)
+            cancellation->throwIfCancelled();
+        try
+        {
+            if (options.timeoutMilliseconds <= 0 && !limited && options.hedgeAfterMilliseconds <= 0 && !cancellation)
+                return direct();
+            auto deadline = end;
+            if (options.timeoutMilliseconds > 0)
+                deadline = std::min(deadline, clock::now() + std::chrono::milliseconds(options.timeoutMilliseconds));
+            return selectInBackground(attempt, options, deadline, cancellation);
+        }
+        catch (TransientError &)
+        {
+            if (limited && clock::now() >= end)
+            {
+                std::stringstream buffer;
+                buffer << "ThermoHubClient query timed out after " << elapsedMilliseconds(start) << " ms in "
+                       << retry + 1 << " attempts" << std::endl;
+                throw TimeoutError(buffer.str());
+            }
+            if (retry >= options.maxRetries)
+                throw;
+        }
+        auto delay = backoffDelay(options, retry);
+        if (limited)
+            delay = std::min(delay, std::chrono::duration_cast<std::chrono::milliseconds>(end - clock::now()));
+        sleepUnlessCancelled(std::max(delay, std::chrono::milliseconds(0)), cancellation);
+    }
+}
+
+auto QueryExecutor::selectInBackground(const Attempt &attempt, const RequestOptions &options, std::chrono::steady_clock::time_point deadline,
+                                       const CancellationToken *cancellation) -> std::vector<std::string>
+{
+    auto attempts = std::make_shared<Attempts>();
+    auto connections = pool;
+
+    // start an attempt in its own thread, with a place taken in the pool; the caller holds the lock of attempts
+    auto launch = [&]() {
+        ++attempts->running;
+        std::thread([attempts, connections, attempt]() {
+            std::vector<std::string> values;
+            std::exception_ptr error;
+            try
+            {
+                values = attempt(*connections);
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            connections->finishAttempt();
+
+            std::lock_guard<std::mutex> lock(attempts->mutex);
+            --attempts->running;
+            if (attempts->done)
+                return;
+            if (!error)
+                attempts->values = std::move(values);
+            else if (attempts->running > 0)
+                return; // the other attempt may still succeed
+            attempts->error = error;
+            attempts->done = true;
+            attempts->finished.notify_all();
+        }).detach();
+    };
+
+    const auto start = clock::now();
+    const bool timed = deadline != clock::time_point::max();
+    bool hedged = options.hedgeAfterMilliseconds <= 0;
+    const auto hedgeTime = start + std::chrono::milliseconds(options.hedgeAfterMilliseconds);
+
+    auto timedOut = [&]() {
+        std::stringstream buffer;
+        buffer << "ThermoHubClient query timed out after " << elapsedMilliseconds(start) << " ms" << std::endl;
+        return TimeoutError(buffer.str());
+    };
+
+    // attempts left behind by timeouts keep their place until the server answers them, so a stalled
+    // server holds at most maxAttemptsInFlight threads and connections
+    if (!pool->startAttempt(options.maxAttemptsInFlight, deadline, cancellation))
+        throw timedOut();
+
+    std::unique_lock<std::mutex> lock(attempts->mutex);
+    launch();
+    while (!attempts->done)
+    {
+        auto wake = clock::now() + (cancellation ? std::chrono::duration_cast<clock::duration>(cancellationInterval) : std::chrono::hours(24));
+        if (timed)
+            wake = std::min(wake, deadline);
+        if (!hedged)
+            wake = std::min(wake, hedgeTime);
+        attempts->finished.wait_until(lock, wake);
+        if (attempts->done)
+            break;
+        auto now = clock::now();
+        if (cancellation && cancellation->isCancelled())
+        {
+            // the running attempts finish in the background
+            attempts->done = true;
+            cancellation->throwIfCancelled();
+        }
+        if (!hedged && now >= hedgeTime)
+        {
+            // no result yet, send the same query on another connection if a place is free
+            hedged = true;
+            if (pool->startAttempt(options.maxAttemptsInFlight, now, nullptr))
+                launch();
+        }
+        if (timed && now >= deadline)
+        {
+            attempts->done = true;
+            throw timedOut();
+        }
+    }
+
+    if (attempts->error)
+        std::rethrow_exception(attempts->error);
+    return std::move(attempts->values);
+}
+
+} // namespace ThermoHubClient
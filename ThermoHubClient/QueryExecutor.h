@@ -0,0 +1,97 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// C++ includes
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ThermoHubClient includes
+#include "DatabaseClient.h"
+#include "RequestControl.h"
+
+// jsonarango
+#include "jsonarango/arangocollection.h"
+#include "jsonarango/arangoexception.h"
+
+namespace ThermoHubClient
+{
+
+/// Runs the AQL selections of a DatabaseClient with its RequestOptions: deadlines of the
+/// attempts and of the whole query, retries of transient errors with jittered exponential backoff,
+/// and hedged duplicate queries. Attempts with a deadline, hedging or a cancellation token run in
+/// their own threads on pooled connections, an attempt left behind by a timeout or a cancellation
+/// returns its connection when it finishes. At most maxAttemptsInFlight attempts run at a time.
+class QueryExecutor
+{
+public:
+    explicit QueryExecutor(const arangocpp::ArangoDBConnection &connection);
+
+    /**
+     * @brief Select the documents of an AQL query
+     *
+     * @param db connection used when neither deadline nor hedging is set
+     * @param collection collection the query is sent to
+     * @param query the AQL query
+     * @param options deadline, retries and hedging
+     * @param cancellation stops waiting for the query with a CancelledError (optional)
+     * @return std::vector<std::string> the selected JSON documents
+     */
+    auto select(arangocpp::ArangoDBCollectionAPI &db, const std::string &collection,
+                const arangocpp::ArangoDBQuery &query, const RequestOptions &options,
+                const CancellationToken *cancellation = nullptr) -> std::vector<std::string>;
+
+    /**
+     * @brief Select the documents of an AQL query through the VelocyPack cursor API
+     *
+     * @param query the AQL query
+     * @param bindVars the bind variables (a JSON object)
+     * @param queryOptions the options of the query (a JSON object)
+     * @param options deadline, retries and hedging
+     * @param cancellation stops waiting for the query with a CancelledError (optional)
+     * @return std::vector<std::string> the VelocyPack of the selected documents
+     */
+    auto selectVelocyPack(const std::string &query, const std::string &bindVars, const std::string &queryOptions,
+                          const RequestOptions &options, const CancellationToken *cancellation = nullptr) -> std::vector<std::string>;
+
+    /// The error thrown for an arango_exception: a TransientError when the server did not answer, or
+    /// answered with an HTTP status or ArangoDB error number of overload or unavailability
+    static auto translate(const arangocpp::arango_exception &e) -> std::exception_ptr;
+
+    /// The error thrown for an error answer of the server with its HTTP status code and ArangoDB error number
+    static auto translate(int code, int errorNum, const std::string &message) -> std::exception_ptr;
+
+private:
+    struct ConnectionPool;
+
+    // one attempt of a query, on a connection of the pool
+    using Attempt = std::function<std::vector<std::string>(ConnectionPool &)>;
+
+    // the attempts of a query with retries; direct is used when neither deadline, hedging nor cancellation is set
+    auto run(const std::function<std::vector<std::string>()> &direct, const Attempt &attempt,
+             const RequestOptions &options, const CancellationToken *cancellation) -> std::vector<std::string>;
+
+    // attempts in their own threads on pooled connections
+    auto selectInBackground(const Attempt &attempt, const RequestOptions &options, std::chrono::steady_clock::time_point deadline,
+                            const CancellationToken *cancellation) -> std::vector<std::string>;
+
+    std::shared_ptr<ConnectionPool> pool;
+};
+
+} // namespace ThermoHubClient
@@ -0,0 +1,161 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "ReactionMatrix.h"
+#include "common/ThreadPool.h"
+
+// C++ includes
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace ThermoHubClient
+{
+
+auto reactionMatrix(const json &thermodataset) -> ReactionMatrix
+{
+    if (!thermodataset.is_object())
+        throw std::runtime_error("ReactionMatrix: the ThermoDataSet must be a JSON object.");
+
+    ReactionMatrix matrix;
+    std::unordered_map<std::string, std::size_t> column;
+    auto substances = thermodataset.find("substances");
+    if (substances != thermodataset.end() && substances->is_array())
+        for (const auto &substance : *substances)
+        {
+            column.emplace(substance.value("symbol", ""), matrix.substances.size());
+            matrix.substances.push_back(substance.value("symbol", ""));
+        }
+
+    matrix.rowOffsets.push_back(0);
+    auto reactions = thermodataset.find("reactions");
+    if (reactions == thermodataset.end() || !reactions->is_array())
+        return matrix;
+
+    std::vector<std::pair<std::size_t, double>> entries;
+    for (const auto &reaction : *reactions)
+    {
+        matrix.reactions.push_back(reaction.value("symbol", ""));
+        matrix.unknownReactants.emplace_back();
+        entries.clear();
+        auto reactants = reaction.find("reactants");
+        if (reactants != reaction.end() && reactants->is_array())
+            for (const auto &reactant : *reactants)
+            {
+                auto symbol = reactant.value("symbol", "");
+                auto itr = column.find(symbol);
+                if (itr == column.end())
+                    matrix.unknownReactants.back().push_back(symbol);
+                else
+                    entries.emplace_back(itr->second, reactant.value("coefficient", 0.));
+            }
+
+        std::sort(entries.begin(), entries.end(), [](const std::pair<std::size_t, double> &a, const std::pair<std::size_t, double> &b) {
+            return a.first < b.first;
+        });
+        for (std::size_t k = 0; k < entries.size(); ++k)
+        {
+            if (k > 0 && entries[k].first == entries[k - 1].first)
+                matrix.values.back() += entries[k].second;
+            else
+            {
+                matrix.columns.push_back(entries[k].first);
+                matrix.values.push_back(entries[k].second);
+            }
+        }
+        matrix.rowOffsets.push_back(matrix.columns.size());
+    }
+    return matrix;
+}
+
+auto checkReactionBalance(const ReactionMatrix &reactions, const FormulaMatrix &formulas, double tolerance,
+                          ThreadPool *pool) -> ReactionBalance
+{
+    if (reactions.substances != formulas.substances)
+        throw std::runtime_error("ReactionBalance: the reaction and formula matrices must have the same substances.");
+
+    // the formula matrix by substance (column-major), to add the elements of each reactant
+    const auto nelements = formulas.rows();
+    std::vector<std::size_t> offsets(formulas.cols() + 1, 0);
+    for (auto j : formulas.columns)
+        ++offsets[j + 1];
+    for (std::size_t j = 0; j < formulas.cols(); ++j)
+        offsets[j + 1] += offsets[j];
+    std::vector<std::size_t> elementRows(formulas.values.size());
+    std::vector<double> amounts(formulas.values.size());
+    {
+        auto next = offsets;
+        for (std::size_t i = 0; i < nelements; ++i)
+            for (auto k = formulas.rowOffsets[i]; k < formulas.rowOffsets[i + 1]; ++k)
+            {
+                auto n = next[formulas.columns[k]]++;
+                elementRows[n] = i;
+                amounts[n] = formulas.values[k];
+            }
+    }
+
+    ReactionBalance balance;
+    balance.reactions = reactions.reactions;
+    balance.elements = formulas.elements;
+    balance.residuals.assign(reactions.rows() * nelements, 0.);
+    std::vector<char> unbalanced(reactions.rows(), 0);
+
+    // the elements of the substances whose formula failed are unknown, their reactions cannot be balanced
+    std::vector<char> failed(formulas.cols(), 0);
+    for (auto j : formulas.failedColumns)
+        failed[j] = 1;
+
+    auto checkReactions = [&](std::size_t begin, std::size_t end) {
+        std::vector<double> scale(nelements);
+        for (auto r = begin; r < end; ++r)
+        {
+            auto residuals = balance.residuals.begin() + static_cast<std::ptrdiff_t>(r * nelements);
+            std::fill(scale.begin(), scale.end(), 0.);
+            unbalanced[r] = !reactions.unknownReactants[r].empty();
+            for (auto k = reactions.rowOffsets[r]; k < reactions.rowOffsets[r + 1]; ++k)
+            {
+                auto j = reactions.columns[k];
+                if (failed[j])
+                    unbalanced[r] = 1;
+                for (auto n = offsets[j]; n < offsets[j + 1]; ++n)
+                {
+                    auto amount = reactions.values[k] * amounts[n];
+                    residuals[elementRows[n]] += amount;
+                    scale[elementRows[n]] += std::abs(amount);
+                }
+            }
+            for (std::size_t e = 0; e < nelements; ++e)
+                if (std::abs(residuals[e]) > tolerance * std::max(1., scale[e]))
+                    unbalanced[r] = 1;
+        }
+    };
+    if (pool)
+        pool->parallelFor(reactions.rows(), std::max<std::size_t>(64, reactions.rows() / (8 * pool->size()) + 1), checkReactions);
+    else
+        checkReactions(0, reactions.rows());
+
+    for (std::size_t r = 0; r < unbalanced.size(); ++r)
+        if (unbalanced[r])
+            balance.unbalanced.push_back(r);
+    return balance;
+}
+
+} // namespace ThermoHubClient
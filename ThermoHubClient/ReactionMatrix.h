@@ -0,0 +1,83 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "FormulaMatrix.h"
+
+// C++ includes
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json_fwd.hpp>
+
+namespace ThermoHubClient
+{
+
+class ThreadPool;
+
+/// Reaction by substance matrix of the reactant coefficients of a ThermoDataSet, with the entries of
+/// each row in column order.
+/// The coefficients of a substance listed twice in a reaction are summed.
+struct ReactionMatrix : CsrMatrix
+{
+    /// reaction symbols, one per row (in the order of the ThermoDataSet)
+    std::vector<std::string> reactions;
+    /// substance symbols, one per column (in the order of the ThermoDataSet)
+    std::vector<std::string> substances;
+
+    /// reactants of each reaction that are not substances of the ThermoDataSet (not in the matrix)
+    std::vector<std::vector<std::string>> unknownReactants;
+
+    auto rows() const -> std::size_t { return reactions.size(); }
+
+    auto cols() const -> std::size_t { return substances.size(); }
+
+    /// The row-major dense matrix (rows() x cols())
+    auto dense() const -> std::vector<double> { return CsrMatrix::dense(cols()); }
+};
+
+struct ReactionBalance
+{
+    /// reaction symbols, one per row
+    std::vector<std::string> reactions;
+    /// element symbols, one per column (the rows of the formula matrix, the charge as Zz)
+    std::vector<std::string> elements;
+    /// row-major matrix of the balance of each element in each reaction (reactions x elements)
+    std::vector<double> residuals;
+    /// positions of the reactions not balanced, with reactants that are not substances of the ThermoDataSet,
+    /// or with reactants in the failed columns of the formula matrix
+    std::vector<std::size_t> unbalanced;
+};
+
+/// Build the reaction matrix of a ThermoDataSet, with the substances of the ThermoDataSet as columns
+auto reactionMatrix(const nlohmann::json &thermodataset) -> ReactionMatrix;
+
+/**
+ * @brief Check the element and charge balance of all reactions at once
+ *
+ * An element is unbalanced in a reaction when its residual is larger than tolerance times the
+ * sum of the absolute amounts of the element in the reactants (at least tolerance).
+ * @param reactions reaction matrix of the ThermoDataSet
+ * @param formulas formula matrix of the same substances, with the charge row to check the charge balance
+ * @param tolerance relative tolerance of the residuals
+ * @param pool thread pool checking the reactions in parallel (optional)
+ */
+auto checkReactionBalance(const ReactionMatrix &reactions, const FormulaMatrix &formulas, double tolerance = 1e-6,
+                          ThreadPool *pool = nullptr) -> ReactionBalance;
+
+} // namespace ThermoHubClient
@@ -0,0 +1,81 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// C++ includes
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace ThermoHubClient
+{
+
+/// A request was cancelled through its CancellationToken
+class CancelledError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/// Cancels the requests of the DatabaseClients it is set on, e.g. from a user interface thread.
+/// Copies share the same state; a cancelled token stays cancelled, further requests need a new one.
+class CancellationToken
+{
+public:
+    CancellationToken() : cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    auto cancel() const -> void { *cancelled = true; }
+
+    auto isCancelled() const -> bool { return *cancelled; }
+
+    /// Throw CancelledError if the token was cancelled
+    auto throwIfCancelled() const -> void
+    {
+        if (isCancelled())
+            throw CancelledError("ThermoHubClient request cancelled");
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled;
+};
+
+/// Stages of a get or save request
+enum class RequestStage
+{
+    Fetch,  ///< the ThermoDataSet is queried from the server (or the cache daemon)
+    Parse,  ///< the query result is parsed
+    Filter, ///< the records are selected by elements and properties
+    Write   ///< the result is written to the database file
+};
+
+/// Progress of a get or save request, reported at each stage and periodically during the long ones
+struct RequestProgress
+{
+    RequestStage stage = RequestStage::Fetch;
+    // size of the query result received, in bytes
+    std::size_t bytesReceived = 0;
+    // records (elements, substances, reactions) parsed
+    std::size_t recordsProcessed = 0;
+    // bytes written to the database file (before compression)
+    std::size_t bytesWritten = 0;
+};
+
+/// Receives the progress of the requests of a DatabaseClient, in the thread running the request
+using ProgressCallback = std::function<void(const RequestProgress &)>;
+
+} // namespace ThermoHubClient
@@ -0,0 +1,51 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// C++ includes
+#include <string>
+#include <vector>
+
+namespace ThermoHubClient
+{
+
+/// Names of the substance properties exported as columns
+const std::vector<std::string> substance_column_properties = {
+    "sm_gibbs_energy", "sm_enthalpy", "sm_entropy_abs", "sm_heat_capacity_p", "sm_volume"};
+
+/// Names of the reaction properties exported as columns
+const std::vector<std::string> reaction_column_properties = {"logKr"};
+
+/// Columnar (one row per record) view of the thermodynamic properties of a ThermoDataSet.
+/// A value is the first entry of the property "values" array, NaN if the property is missing.
+struct ThermoDataColumns
+{
+    /// substance property names, one per column
+    std::vector<std::string> substanceProperties = substance_column_properties;
+    /// substance symbols, one per row (in the order of the ThermoDataSet)
+    std::vector<std::string> substanceSymbols;
+    /// row-major matrix of substance property values (substanceSymbols x substanceProperties)
+    std::vector<double> substanceValues;
+
+    /// reaction property names, one per column
+    std::vector<std::string> reactionProperties = reaction_column_properties;
+    /// reaction symbols, one per row (in the order of the ThermoDataSet)
+    std::vector<std::string> reactionSymbols;
+    /// row-major matrix of reaction property values (reactionSymbols x reactionProperties)
+    std::vector<double> reactionValues;
+};
+
+} // namespace ThermoHubClient
@@ -0,0 +1,232 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "ThermoDataSetDiff.h"
+#include "DatabaseFile.h"
+
+// C++ includes
+#include <algorithm>
+#include <istream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace ThermoHubClient
+{
+
+/// 64-bit FNV-1a hash of the canonical content of a JSON value
+class ContentHash
+{
+public:
+    auto value() const -> std::uint64_t { return hash; }
+
+    auto add(const json &value) -> void
+    {
+        switch (value.type())
+        {
+        case json::value_t::object:
+            // the keys of an object are sorted, null properties and array items are left out as when the database is parsed
+            tag('{');
+            for (auto it = value.begin(); it != value.end(); ++it)
+                if (!it->is_null())
+                {
+                    bytes(it.key().data(), it.key().size() + 1);
+                    add(*it);
+                }
+            tag('}');
+            break;
+        case json::value_t::array:
+            tag('[');
+            for (const auto &item : value)
+                if (!item.is_null())
+                    add(item);
+            tag(']');
+            break;
+        case json::value_t::string:
+        {
+            const auto &text = value.get_ref<const std::string &>();
+            tag('"');
+            bytes(text.data(), text.size() + 1);
+            break;
+        }
+        case json::value_t::number_integer:
+        case json::value_t::number_unsigned:
+        case json::value_t::number_float:
+        {
+            // the numbers are compared as doubles, with 0 and -0 equal
+            auto number = value.get<double>();
+            number = number == 0. ? 0. : number;
+            tag('#');
+            bytes(&number, sizeof(number));
+            break;
+        }
+        case json::value_t::boolean:
+            tag(value.get<bool>() ? 't' : 'f');
+            break;
+        default:
+            tag('0');
+            break;
+        }
+    }
+
+private:
+    std::uint64_t hash = 14695981039346656037ull;
+
+    auto tag(char ch) -> void
+    {
+        bytes(&ch, 1);
+    }
+
+    auto bytes(const void *data, std::size_t size) -> void
+    {
+        const auto *begin = static_cast<const unsigned char *>(data);
+        for (std::size_t i = 0; i < size; ++i)
+            hash = (hash ^ begin[i]) * 1099511628211ull;
+    }
+};
+
+static auto recordHash(const json &record) -> std::uint64_t
+{
+    ContentHash hash;
+    hash.add(record);
+    return hash.value();
+}
+
+// the hashes of an array of records, nullptr if the name is not one of the record arrays
+static auto recordHashes(ThermoDataSetHashes &hashes, const std::string &name) -> RecordHashes *
+{
+    if (name == "elements")
+        return &hashes.elements;
+    if (name == "substances")
+        return &hashes.substances;
+    if (name == "reactions")
+        return &hashes.reactions;
+    return nullptr;
+}
+
+auto hashThermoDataSet(const json &thermodataset) -> ThermoDataSetHashes
+{
+    if (!thermodataset.is_object())
+        throw std::runtime_error("ThermoDataSetDiff: the ThermoDataSet must be a JSON object.");
+    ThermoDataSetHashes hashes;
+    for (auto it = thermodataset.begin(); it != thermodataset.end(); ++it)
+    {
+        auto records = recordHashes(hashes, it.key());
+        if (records && it->is_array())
+            for (const auto &record : *it)
+                records->emplace_back(record.value("symbol", ""), recordHash(record));
+    }
+    return hashes;
+}
+
+// parse a ThermoDataSet from input, hashing each record of the elements, substances and reactions
+// as soon as it is parsed and discarding it
+template <typename Input>
+static auto hashRecordsWhileParsing(Input &&input) -> ThermoDataSetHashes
+{
+    ThermoDataSetHashes hashes;
+    RecordHashes *records = nullptr;
+    auto document = json::parse(std::forward<Input>(input), [&](int depth, json::parse_event_t event, json &parsed) {
+        if (depth == 1 && event == json::parse_event_t::key)
+            records = recordHashes(hashes, parsed.get<std::string>());
+        else if (depth == 2 && event == json::parse_event_t::object_end && records)
+        {
+            records->emplace_back(parsed.value("symbol", ""), recordHash(parsed));
+            return false;
+        }
+        return true;
+    });
+    if (!document.is_object())
+        throw std::runtime_error("ThermoDataSetDiff: the ThermoDataSet must be a JSON object.");
+    return hashes;
+}
+
+auto hashThermoDataSetText(const std::string &jsondata) -> ThermoDataSetHashes
+{
+    return hashRecordsWhileParsing(jsondata);
+}
+
+auto hashDatabaseFile(const std::string &fileName) -> ThermoDataSetHashes
+{
+    DecompressedFileBuffer buffer(fileName, compressionFromFileName(fileName));
+    std::istream stream(&buffer);
+    return hashRecordsWhileParsing(stream);
+}
+
+// the content hashes of the records of each symbol, sorted
+static auto hashesBySymbol(const RecordHashes &records) -> std::unordered_map<std::string, std::vector<std::uint64_t>>
+{
+    std::unordered_map<std::string, std::vector<std::uint64_t>> hashes;
+    for (const auto &record : records)
+        hashes[record.first].push_back(record.second);
+    for (auto &symbol : hashes)
+        std::sort(symbol.second.begin(), symbol.second.end());
+    return hashes;
+}
+
+static auto diffRecords(const RecordHashes &before, const RecordHashes &after) -> RecordChanges
+{
+    RecordChanges changes;
+    auto beforeHashes = hashesBySymbol(before);
+    auto afterHashes = hashesBySymbol(after);
+    std::unordered_set<std::string> seen;
+    for (const auto &record : after)
+    {
+        if (!seen.insert(record.first).second)
+            continue;
+        auto itr = beforeHashes.find(record.first);
+        if (itr == beforeHashes.end())
+            changes.added.push_back(record.first);
+        else if (itr->second != afterHashes[record.first])
+            changes.modified.push_back(record.first);
+        if (afterHashes[record.first].size() > 1 || (itr != beforeHashes.end() && itr->second.size() > 1))
+            changes.duplicated.push_back(record.first);
+    }
+    for (const auto &record : before)
+    {
+        if (!seen.insert(record.first).second)
+            continue;
+        changes.removed.push_back(record.first);
+        if (beforeHashes[record.first].size() > 1)
+            changes.duplicated.push_back(record.first);
+    }
+    return changes;
+}
+
+auto diffThermoDataSets(const ThermoDataSetHashes &before, const ThermoDataSetHashes &after) -> ThermoDataSetDiff
+{
+    ThermoDataSetDiff diff;
+    diff.elements = diffRecords(before.elements, after.elements);
+    diff.substances = diffRecords(before.substances, after.substances);
+    diff.reactions = diffRecords(before.reactions, after.reactions);
+    return diff;
+}
+
+auto diffThermoDataSets(const json &before, const json &after) -> ThermoDataSetDiff
+{
+    return diffThermoDataSets(hashThermoDataSet(before), hashThermoDataSet(after));
+}
+
+auto diffDatabaseFiles(const std::string &beforeFileName, const std::string &afterFileName) -> ThermoDataSetDiff
+{
+    return diffThermoDataSets(hashDatabaseFile(beforeFileName), hashDatabaseFile(afterFileName));
+}
+
+} // namespace ThermoHubClient
@@ -0,0 +1,88 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+// C++ includes
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json_fwd.hpp>
+
+namespace ThermoHubClient
+{
+
+/// Symbol and content hash of each record of an array of a ThermoDataSet, in the order of the ThermoDataSet
+using RecordHashes = std::vector<std::pair<std::string, std::uint64_t>>;
+
+/// Content hashes of the elements, substances and reactions of a ThermoDataSet. The hash of a record
+/// does not depend on the order of its properties, on null properties or on the writing of its
+/// numbers (1 and 1.0 are the same number).
+struct ThermoDataSetHashes
+{
+    RecordHashes elements;
+    RecordHashes substances;
+    RecordHashes reactions;
+};
+
+/// Symbols of the records added, removed and modified in an array of a ThermoDataSet
+struct RecordChanges
+{
+    /// records only in the new version (in its order)
+    std::vector<std::string> added;
+    /// records only in the old version (in its order)
+    std::vector<std::string> removed;
+    /// records of both versions with a different content (in the order of the new version)
+    std::vector<std::string> modified;
+    /// symbols of more than one record in either version (in the order of the new version, then of the old one);
+    /// such a symbol is modified when its records differ in content or number
+    std::vector<std::string> duplicated;
+
+    /// No record added, removed or modified (duplicated symbols are not changes)
+    auto empty() const -> bool { return added.empty() && removed.empty() && modified.empty(); }
+};
+
+/// Changes of the records between two versions of a ThermoDataSet, matched by symbol
+struct ThermoDataSetDiff
+{
+    RecordChanges elements;
+    RecordChanges substances;
+    RecordChanges reactions;
+
+    auto empty() const -> bool { return elements.empty() && substances.empty() && reactions.empty(); }
+};
+
+/// Hash the records of a ThermoDataSet
+auto hashThermoDataSet(const nlohmann::json &thermodataset) -> ThermoDataSetHashes;
+
+/// Hash the records of a ThermoDataSet JSON string, parsed one record at a time
+auto hashThermoDataSetText(const std::string &jsondata) -> ThermoDataSetHashes;
+
+/// Hash the records of a (compressed) database file, read and parsed one record at a time
+auto hashDatabaseFile(const std::string &fileName) -> ThermoDataSetHashes;
+
+/// Compare the records of two versions of a ThermoDataSet, in linear time
+auto diffThermoDataSets(const ThermoDataSetHashes &before, const ThermoDataSetHashes &after) -> ThermoDataSetDiff;
+
+/// Compare the records of two versions of a ThermoDataSet
+auto diffThermoDataSets(const nlohmann::json &before, const nlohmann::json &after) -> ThermoDataSetDiff;
+
+/// Compare the records of two (compressed) database files, streamed: only the hashes of the records are kept in memory
+auto diffDatabaseFiles(const std::string &beforeFileName, const std::string &afterFileName) -> ThermoDataSetDiff;
+
+} // namespace ThermoHubClient
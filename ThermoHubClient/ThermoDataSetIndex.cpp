@@ -0,0 +1,324 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ThermoDataSetIndex.h"
+#include "DatabaseFile.h"
+#include "ElementFilter.h"
+#include "formulaparser/FormulaBatch.h"
+
+// C++ includes
+#include <algorithm>
+#include <istream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace ThermoHubClient
+{
+
+using SymbolSet = std::unordered_set<std::string>;
+
+struct ThermoDataSetIndex::Impl
+{
+    json thermodataset;
+
+    // position of the substances and reactions by symbol
+    std::unordered_map<std::string, std::size_t> substanceBySymbol;
+    std::unordered_map<std::string, std::size_t> reactionBySymbol;
+
+    // positions of the substances by class_ and by aggregate_state (keys are compact JSON strings)
+    std::unordered_map<std::string, std::vector<std::size_t>> substancesByClass;
+    std::unordered_map<std::string, std::vector<std::size_t>> substancesByAggregateState;
+
+    // class_ and aggregate_state keys of each substance
+    std::vector<std::string> substanceClass;
+    std::vector<std::string> substanceAggregateState;
+
+    // element ids in the formula of each substance (with Zz for charged formulas), and the formula
+    // parser error of each substance
+    FormulaParser::FormulaCompositions compositions;
+
+    // formula matrices without and with the charge row, built by the first request
+    mutable std::once_flag formulaMatrixOnce[2];
+    mutable FormulaMatrix formulaMatrices[2];
+
+    // positions of the reactions defining each substance
+    std::vector<std::vector<std::size_t>> substanceReactions;
+
+    explicit Impl(json &&thermodataset_) : thermodataset(std::move(thermodataset_))
+    {
+        if (!thermodataset.is_object())
+            throw std::runtime_error("ThermoDataSetIndex: the ThermoDataSet must be a JSON object.");
+        for (const auto &name : {"elements", "substances", "reactions"})
+            if (thermodataset.find(name) == thermodataset.end())
+                thermodataset[name] = json::array();
+
+        const auto &reactions = thermodataset["reactions"];
+        for (std::size_t i = 0; i < reactions.size(); ++i)
+            reactionBySymbol.emplace(reactions[i].value("symbol", ""), i);
+
+        auto &substances = thermodataset["substances"];
+        const auto nsubstances = substances.size();
+        substanceClass.resize(nsubstances);
+        substanceAggregateState.resize(nsubstances);
+        substanceReactions.resize(nsubstances);
+
+        std::vector<std::string> formulas(nsubstances);
+        bool definingReactions = false;
+        std::vector<char> named(reactions.size());
+        for (std::size_t i = 0; i < nsubstances; ++i)
+        {
+            auto &substance = substances[i];
+            substanceBySymbol.emplace(substance.value("symbol", ""), i);
+
+            substanceClass[i] = key(substance, "class_");
+            substancesByClass[substanceClass[i]].push_back(i);
+            substanceAggregateState[i] = key(substance, "aggregate_state");
+            substancesByAggregateState[substanceAggregateState[i]].push_back(i);
+
+            // all reactions defining the substance if they were queried (DatabaseClient cache), otherwise
+            // the reaction property (a ThermoDataSet loaded from a database file)
+            auto defining = substance.find("defining_reactions");
+            if (defining != substance.end())
+            {
+                definingReactions = true;
+                for (const auto &symbol : *defining)
+                    addReaction(i, symbol.is_string() ? symbol.get<std::string>() : "");
+                substance.erase(defining);
+            }
+            else
+            {
+                auto reaction = addReaction(i, substance.value("reaction", ""));
+                if (reaction < named.size())
+                    named[reaction] = 1;
+            }
+
+            formulas[i] = substance.value("formula", "");
+        }
+
+        // without the defining_reactions lists, a reaction no reaction property refers to (e.g. a
+        // reaction defining several substances) belongs to the substances among its reactants
+        for (std::size_t r = 0; r < reactions.size() && !definingReactions; ++r)
+        {
+            auto reactants = reactions[r].find("reactants");
+            if (named[r] || reactants == reactions[r].end() || !reactants->is_array())
+                continue;
+            for (const auto &reactant : *reactants)
+            {
+                auto itr = substanceBySymbol.find(reactant.value("symbol", ""));
+                if (itr != substanceBySymbol.end())
+                    substanceReactions[itr->second].push_back(r);
+            }
+        }
+
+        // all formulas are parsed at once, with an error per formula
+        compositions = FormulaParser::parseMany(formulas);
+    }
+
+    // position of the reaction added to the reactions defining the substance, the number of reactions if unknown
+    auto addReaction(std::size_t substance, const std::string &symbol) -> std::size_t
+    {
+        auto itr = reactionBySymbol.find(symbol);
+        if (itr == reactionBySymbol.end())
+            return thermodataset["reactions"].size();
+        substanceReactions[substance].push_back(itr->second);
+        return itr->second;
+    }
+
+    // index key of a property value
+    static auto key(const json &record, const std::string &property) -> std::string
+    {
+        auto itr = record.find(property);
+        return itr == record.end() ? "null" : itr->dump();
+    }
+
+    // index key of a class_ or aggregate_state given in a DatabaseClient selection list
+    static auto listKey(const std::string &value) -> std::string
+    {
+        try
+        {
+            return json::parse(value).dump();
+        }
+        catch (json::exception &)
+        {
+            return json(value).dump();
+        }
+    }
+
+    static auto listKeys(const std::vector<std::string> &values) -> SymbolSet
+    {
+        SymbolSet keys;
+        for (const auto &value : values)
+            keys.insert(listKey(value));
+        return keys;
+    }
+
+    // substances selected by symbol, class_ and aggregate_state, in the order of the ThermoDataSet
+    auto selectSubstances(const std::vector<std::string> &symbols, const std::vector<std::string> &classes,
+                          const std::vector<std::string> &aggregateStates) const -> std::vector<std::size_t>
+    {
+        const auto classKeys = listKeys(classes);
+        const auto aggregateStateKeys = listKeys(aggregateStates);
+
+        // start from the most selective index
+        std::vector<std::size_t> candidates;
+        if (!symbols.empty())
+        {
+            for (const auto &symbol : symbols)
+            {
+                auto itr = substanceBySymbol.find(symbol);
+                if (itr != substanceBySymbol.end())
+                    candidates.push_back(itr->second);
+            }
+        }
+        else if (!classKeys.empty() || !aggregateStateKeys.empty())
+        {
+            const auto &index = classKeys.empty() ? substancesByAggregateState : substancesByClass;
+            for (const auto &key : classKeys.empty() ? aggregateStateKeys : classKeys)
+            {
+                auto itr = index.find(key);
+                if (itr != index.end())
+                    candidates.insert(candidates.end(), itr->second.begin(), itr->second.end());
+            }
+        }
+        else
+        {
+            candidates.resize(substanceClass.size());
+            for (std::size_t i = 0; i < candidates.size(); ++i)
+                candidates[i] = i;
+            return candidates;
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](std::size_t i) {
+                             return (!classKeys.empty() && !classKeys.count(substanceClass[i])) ||
+                                    (!aggregateStateKeys.empty() && !aggregateStateKeys.count(substanceAggregateState[i]));
+                         }),
+                         candidates.end());
+        return candidates;
+    }
+
+    auto formulaMatrix(bool chargeRow) const -> const FormulaMatrix &
+    {
+        std::call_once(formulaMatrixOnce[chargeRow], [&]() {
+            std::vector<std::string> elementSymbols, substanceSymbols;
+            for (const auto &element : thermodataset["elements"])
+                elementSymbols.push_back(element.value("symbol", ""));
+            for (const auto &substance : thermodataset["substances"])
+                substanceSymbols.push_back(substance.value("symbol", ""));
+            formulaMatrices[chargeRow] = ThermoHubClient::formulaMatrix(elementSymbols, substanceSymbols, compositions, chargeRow);
+        });
+        return formulaMatrices[chargeRow];
+    }
+
+    auto subset(const std::vector<std::string> &elementsList, const std::vector<std::string> &substancesList,
+                const std::vector<std::string> &classesOfSubstance, const std::vector<std::string> &aggregateStates,
+                bool filterCharge) const -> json
+    {
+        const auto &elements = thermodataset["elements"];
+        const auto &substances = thermodataset["substances"];
+        const auto &reactions = thermodataset["reactions"];
+
+        auto selectedSubstances = selectSubstances(substancesList, classesOfSubstance, aggregateStates);
+
+        // without a selection of substances all reactions are kept, else those defining the selected substances
+        std::vector<std::size_t> selectedReactions;
+        if (substancesList.empty() && classesOfSubstance.empty() && aggregateStates.empty())
+        {
+            selectedReactions.resize(reactions.size());
+            for (std::size_t i = 0; i < selectedReactions.size(); ++i)
+                selectedReactions[i] = i;
+        }
+        else
+        {
+            for (auto i : selectedSubstances)
+                selectedReactions.insert(selectedReactions.end(), substanceReactions[i].begin(), substanceReactions[i].end());
+            std::sort(selectedReactions.begin(), selectedReactions.end());
+            selectedReactions.erase(std::unique(selectedReactions.begin(), selectedReactions.end()), selectedReactions.end());
+        }
+
+        json result = json::object();
+        for (auto it = thermodataset.begin(); it != thermodataset.end(); ++it)
+            if (it.key() != "elements" && it.key() != "substances" && it.key() != "reactions")
+                result[it.key()] = it.value();
+
+        auto &jElements = result["elements"] = json::array();
+        auto &jSubstances = result["substances"] = json::array();
+        auto &jReactions = result["reactions"] = json::array();
+
+        jElements = elements;
+        for (auto i : selectedSubstances)
+            jSubstances.push_back(substances[i]);
+        for (auto i : selectedReactions)
+            jReactions.push_back(reactions[i]);
+        if (elementsList.empty())
+            return result;
+
+        // the formulas were parsed with the index
+        ElementFilter filter(elementsList, filterCharge);
+        std::vector<char> keep(selectedSubstances.size());
+        for (std::size_t k = 0; k < keep.size(); ++k)
+            keep[k] = filter.containsFormula(compositions, selectedSubstances[k]);
+        filter.select(result, keep);
+        return result;
+    }
+};
+
+ThermoDataSetIndex::ThermoDataSetIndex(json thermodataset)
+    : pimpl(std::make_shared<const Impl>(std::move(thermodataset)))
+{
+}
+
+ThermoDataSetIndex::ThermoDataSetIndex(const std::string &jsondata)
+    : ThermoDataSetIndex(json::parse(jsondata))
+{
+}
+
+auto ThermoDataSetIndex::fromFile(const std::string &fileName) -> ThermoDataSetIndex
+{
+    // parse while decompressing
+    DecompressedFileBuffer buffer(fileName, compressionFromFileName(fileName));
+    std::istream stream(&buffer);
+    return ThermoDataSetIndex(json::parse(stream));
+}
+
+auto ThermoDataSetIndex::subset(const std::vector<std::string> &elements, const std::vector<std::string> &substances,
+                                const std::vector<std::string> &classesOfSubstance, const std::vector<std::string> &aggregateStates,
+                                bool filterCharge) const -> json
+{
+    return pimpl->subset(elements, substances, classesOfSubstance, aggregateStates, filterCharge);
+}
+
+auto ThermoDataSetIndex::formulaMatrix(bool chargeRow) const -> const FormulaMatrix &
+{
+    return pimpl->formulaMatrix(chargeRow);
+}
+
+auto ThermoDataSetIndex::formulaCompositions() const -> const FormulaParser::FormulaCompositions &
+{
+    return pimpl->compositions;
+}
+
+auto ThermoDataSetIndex::thermoDataSet() const -> const json &
+{
+    return pimpl->thermodataset;
+}
+
+} // namespace ThermoHubClient
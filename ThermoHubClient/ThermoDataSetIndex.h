@@ -0,0 +1,83 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "FormulaMatrix.h"
+
+// C++ includes
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json_fwd.hpp>
+
+namespace FormulaParser {
+struct FormulaCompositions;
+}
+
+namespace ThermoHubClient
+{
+
+/// Local query engine over a complete ThermoDataSet held in memory.
+/// A subset gives the same records as the server query of DatabaseClient (selection of substances
+/// by symbol, class_ and aggregate_state, reactions defining the selected substances, all reactions
+/// without such a selection) followed by the selection of the data containing a list of elements.
+/// The reactions defining a substance are taken from its defining_reactions list (queried for the
+/// DatabaseClient cache, and removed from the records when indexed), or else from its reaction
+/// property and from the reactants of the reactions no reaction property refers to (e.g. a
+/// ThermoDataSet read from a file).
+class ThermoDataSetIndex
+{
+public:
+    /// Build the indexes of a complete ThermoDataSet
+    explicit ThermoDataSetIndex(nlohmann::json thermodataset);
+
+    /// Build the indexes of a complete ThermoDataSet given as JSON string
+    explicit ThermoDataSetIndex(const std::string &jsondata);
+
+    /// Build the indexes of a complete ThermoDataSet read from a (compressed) database file
+    static auto fromFile(const std::string &fileName) -> ThermoDataSetIndex;
+
+    /**
+     * @brief Select a subset of the ThermoDataSet
+     *
+     * @param elements vector of elements symbols (optional)
+     * @param substances vector of substances symbols (optional)
+     * @param classesOfSubstance vector of substances classes as JSON strings, e.g. {"1":"SC_GASFLUID"} (optional)
+     * @param aggregateStates vector of substances aggregate states as JSON strings, e.g. {"4":"AS_AQUEOUS"} (optional)
+     * @param filterCharge do not add the charge Zz to the elements
+     * @return nlohmann::json the selected ThermoDataSet
+     */
+    auto subset(const std::vector<std::string> &elements, const std::vector<std::string> &substances,
+                const std::vector<std::string> &classesOfSubstance, const std::vector<std::string> &aggregateStates,
+                bool filterCharge) const -> nlohmann::json;
+
+    /// Formula matrix of the complete ThermoDataSet, built once and kept with the index
+    auto formulaMatrix(bool chargeRow = true) const -> const FormulaMatrix &;
+
+    /// Compositions of the formulas of the substances, parsed with the index
+    auto formulaCompositions() const -> const FormulaParser::FormulaCompositions &;
+
+    /// The complete ThermoDataSet
+    auto thermoDataSet() const -> const nlohmann::json &;
+
+private:
+    struct Impl;
+
+    std::shared_ptr<const Impl> pimpl;
+};
+
+} // namespace ThermoHubClient
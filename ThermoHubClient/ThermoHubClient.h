@@ -16,4 +16,16 @@
 // along with thermohubclient.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "DatabaseClient.h"
-#include "formulaparser/FormulaParser.h"
\ No newline at end of file
+#include "ThermoDataColumns.h"
+#include "FormulaMatrix.h"
+#include "ReactionMatrix.h"
+#include "MolarMassCharge.h"
+#include "DatabaseFile.h"
+#include "DatabaseResult.h"
+#include "RequestControl.h"
+#include "ElementFilter.h"
+#include "ThermoDataSetIndex.h"
+#include "ThermoDataSetDiff.h"
+#include "CacheDaemon.h"
+#include "formulaparser/FormulaParser.h"
+#include "formulaparser/FormulaBatch.h"
\ No newline at end of file
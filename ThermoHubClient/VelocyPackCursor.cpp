@@ -0,0 +1,158 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "VelocyPackCursor.h"
+#include "QueryExecutor.h"
+#include "common/VelocyPackView.h"
+
+// C++ includes
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+
+namespace ThermoHubClient
+{
+
+namespace
+{
+
+auto appendBody(char *data, std::size_t size, std::size_t count, void *body) -> std::size_t
+{
+    static_cast<std::string *>(body)->append(data, size * count);
+    return size * count;
+}
+
+// the integer member of an answer of the server, 0 if there is none
+auto integerMember(const VelocyPackView &answer, const std::string &key) -> int
+{
+    auto value = answer.find(key);
+    return value.isInteger() ? static_cast<int>(value.intValue()) : 0;
+}
+
+} // namespace
+
+struct VelocyPackCursor::Impl
+{
+    // server URL of the database, e.g. http://localhost:8529/_db/hub_main
+    std::string database;
+
+    std::string user;
+
+    std::string password;
+
+    CURL *curl = nullptr;
+
+    explicit Impl(const arangocpp::ArangoDBConnection &connection)
+        : database(connection.serverUrl + "/_db/" + connection.user.databaseName),
+          user(connection.user.name), password(connection.user.password)
+    {
+        static std::once_flag initialized;
+        std::call_once(initialized, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+        curl = curl_easy_init();
+        if (!curl)
+            throw std::runtime_error("ThermoHubClient: the VelocyPack connection could not be created.");
+    }
+
+    ~Impl()
+    {
+        curl_easy_cleanup(curl);
+    }
+
+    // send a request of the cursor API, and return the VelocyPack answer of the server
+    auto request(const char *method, const std::string &path, const std::string &body, std::string &answer) -> VelocyPackView
+    {
+        const auto url = database + path;
+        answer.clear();
+        curl_easy_reset(curl);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+        curl_easy_setopt(curl, CURLOPT_USERNAME, user.c_str());
+        curl_easy_setopt(curl, CURLOPT_PASSWORD, password.c_str());
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, appendBody);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &answer);
+        curl_slist *headers = nullptr;
+        headers = curl_slist_append(headers, "Accept: application/x-velocypack");
+        headers = curl_slist_append(headers, "Content-Type: application/json");
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        auto result = curl_easy_perform(curl);
+        curl_slist_free_all(headers);
+
+        // a request the server did not answer failed in the connection
+        if (result != CURLE_OK)
+            throw TransientError("ThermoHubClient VelocyPack request to " + url + " failed: " + curl_easy_strerror(result));
+        long code = 0;
+        char *contentType = nullptr;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+        curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &contentType);
+        if (!contentType || std::string(contentType).find("application/x-velocypack") == std::string::npos)
+        {
+            std::stringstream buffer;
+            buffer << "ThermoHubClient VelocyPack request to " << url << " answered with HTTP " << code << " and "
+                   << (contentType ? contentType : "no content type") << std::endl
+                   << answer.substr(0, 1024) << std::endl;
+            std::rethrow_exception(QueryExecutor::translate(static_cast<int>(code), 0, buffer.str()));
+        }
+
+        VelocyPackView document(answer.data(), answer.data() + answer.size());
+        auto error = document.find("error");
+        if (code >= 300 || (error.isBool() && error.boolValue()))
+        {
+            std::stringstream buffer;
+            buffer << "ThermoHubClient VelocyPack request to " << url << " failed" << std::endl
+                   << "HTTP " << code << ", errorNum " << integerMember(document, "errorNum") << ": "
+                   << document.find("errorMessage").stringValue() << std::endl;
+            std::rethrow_exception(QueryExecutor::translate(static_cast<int>(code), integerMember(document, "errorNum"), buffer.str()));
+        }
+        return document;
+    }
+};
+
+VelocyPackCursor::VelocyPackCursor(const arangocpp::ArangoDBConnection &connection)
+    : pimpl(new Impl(connection))
+{
+}
+
+VelocyPackCursor::~VelocyPackCursor() = default;
+
+auto VelocyPackCursor::select(const std::string &query, const std::string &bindVars, const std::string &options) -> std::vector<std::string>
+{
+    nlohmann::json cursor;
+    cursor["query"] = query;
+    cursor["bindVars"] = nlohmann::json::parse(bindVars);
+    cursor["options"] = nlohmann::json::parse(options);
+
+    std::vector<std::string> documents;
+    std::string answer;
+    auto batch = pimpl->request("POST", "/_api/cursor", cursor.dump(), answer);
+    for (;;)
+    {
+        batch.find("result").forEachElement([&documents](const VelocyPackView &document) {
+            documents.emplace_back(document.data(), document.byteSize());
+        });
+        auto hasMore = batch.find("hasMore");
+        if (!hasMore.isBool() || !hasMore.boolValue())
+            return documents;
+        batch = pimpl->request("PUT", "/_api/cursor/" + batch.find("id").stringValue(), "", answer);
+    }
+}
+
+} // namespace ThermoHubClient
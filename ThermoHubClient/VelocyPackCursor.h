@@ -0,0 +1,59 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+// C++ includes
+#include <memory>
+#include <string>
+#include <vector>
+
+// jsonarango
+#include "jsonarango/arangocollection.h"
+
+namespace ThermoHubClient
+{
+
+/// AQL cursor requests answered by the server as VelocyPack. jsonarango converts the VelocyPack answers
+/// to JSON text before handing them out, so these requests are sent with libcurl, and the result
+/// documents are kept as the VelocyPack the server sent. One connection, kept open between requests;
+/// not thread-safe.
+class VelocyPackCursor
+{
+public:
+    /// Cursor on the server and database of the connection data, with its user
+    explicit VelocyPackCursor(const arangocpp::ArangoDBConnection &connection);
+
+    ~VelocyPackCursor();
+
+    /**
+     * @brief Select the documents of an AQL query, with all the batches of the cursor
+     *
+     * @param query the AQL query
+     * @param bindVars the bind variables (a JSON object)
+     * @param options the query options (a JSON object)
+     * @return std::vector<std::string> the VelocyPack of the selected documents
+     * Throws a TransientError when the server did not answer or answered with an overload error.
+     */
+    auto select(const std::string &query, const std::string &bindVars, const std::string &options) -> std::vector<std::string>;
+
+private:
+    struct Impl;
+
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace ThermoHubClient
@@ -0,0 +1,225 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// C++ includes
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json_fwd.hpp>
+
+namespace ThermoHubClient
+{
+
+/// Memory arena of a single request. Blocks are carved out of large chunks in size classes, a freed
+/// block goes to the free list of its class and is reused by the next allocation of that class (e.g.
+/// the buffers outgrown by growing arrays), and the chunks are released all together with the arena.
+/// Blocks larger than the largest class are taken from the heap and given back to it when freed.
+/// Not thread-safe: an arena is used by the thread of its request.
+class RequestArena
+{
+public:
+    /// Alignment of all blocks
+    static constexpr std::size_t alignment = 16;
+
+    /// Largest block served from the chunks
+    static constexpr std::size_t maxClassSize = std::size_t(1) << 16;
+
+    explicit RequestArena(std::size_t chunkSize_ = std::size_t(1) << 20)
+        : chunkSize(((chunkSize_ > maxClassSize ? chunkSize_ : maxClassSize) + alignment - 1) / alignment * alignment)
+    {
+    }
+
+    RequestArena(const RequestArena &) = delete;
+    RequestArena &operator=(const RequestArena &) = delete;
+
+    /// Allocate a block of size bytes
+    auto allocate(std::size_t size) -> void *
+    {
+        if (size > maxClassSize)
+            return ::operator new(size);
+        const auto index = sizeClass(size);
+        if (auto block = freeBlocks[index])
+        {
+            freeBlocks[index] = block->next;
+            return block;
+        }
+        const auto length = classSize(index);
+        if (length > remaining)
+            addChunk();
+        auto block = current;
+        current += length;
+        remaining -= length;
+        return block;
+    }
+
+    /// Give back a block of size bytes allocated by this arena
+    auto deallocate(void *ptr, std::size_t size) noexcept -> void
+    {
+        if (size > maxClassSize)
+            return ::operator delete(ptr);
+        const auto index = sizeClass(size);
+        auto block = static_cast<FreeBlock *>(ptr);
+        block->next = freeBlocks[index];
+        freeBlocks[index] = block;
+    }
+
+    /// Number of chunks allocated from the heap
+    auto chunkCount() const -> std::size_t { return chunks.size(); }
+
+private:
+    // multiples of 16 bytes up to 256, then four classes per doubling up to maxClassSize
+    static constexpr std::size_t smallClasses = 16;
+    static constexpr std::size_t classCount = smallClasses + 4 * 8;
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    struct alignas(alignment) Chunk
+    {
+        char bytes[alignment];
+    };
+
+    // start a new chunk, the rest of the current one goes to the free lists
+    auto addChunk() -> void
+    {
+        for (auto index = classCount; remaining >= alignment && index-- > 0;)
+            while (classSize(index) <= remaining)
+            {
+                deallocate(current, classSize(index));
+                current += classSize(index);
+                remaining -= classSize(index);
+            }
+        chunks.emplace_back(new Chunk[chunkSize / sizeof(Chunk)]);
+        current = reinterpret_cast<char *>(chunks.back().get());
+        remaining = chunkSize;
+    }
+
+    static auto sizeClass(std::size_t size) -> std::size_t
+    {
+        if (size <= 256)
+            return size == 0 ? 0 : (size - 1) / 16;
+        std::size_t base = 256, doubling = 0;
+        while (size > 2 * base)
+        {
+            base *= 2;
+            ++doubling;
+        }
+        const auto step = base / 4;
+        return smallClasses + 4 * doubling + (size - base - 1) / step;
+    }
+
+    static auto classSize(std::size_t index) -> std::size_t
+    {
+        if (index < smallClasses)
+            return 16 * (index + 1);
+        const auto doubling = (index - smallClasses) / 4;
+        const auto base = std::size_t(256) << doubling;
+        return base + (base / 4) * ((index - smallClasses) % 4 + 1);
+    }
+
+    std::size_t chunkSize;
+
+    std::vector<std::unique_ptr<Chunk[]>> chunks;
+
+    char *current = nullptr;
+
+    std::size_t remaining = 0;
+
+    std::array<FreeBlock *, classCount> freeBlocks{};
+};
+
+namespace internal {
+
+/// The arena used by ArenaAllocator in this thread
+inline auto currentArena() -> RequestArena *&
+{
+    static thread_local RequestArena *arena = nullptr;
+    return arena;
+}
+
+} // namespace internal
+
+/// Makes an arena the one used by ArenaAllocator in this thread while the scope lasts
+class ArenaScope
+{
+public:
+    explicit ArenaScope(RequestArena &arena) : previous(internal::currentArena())
+    {
+        internal::currentArena() = &arena;
+    }
+
+    ~ArenaScope()
+    {
+        internal::currentArena() = previous;
+    }
+
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+    RequestArena *previous;
+};
+
+/// Stateless allocator taking its memory from the arena of the current ArenaScope. Objects using it
+/// must be created and destroyed in the thread and the scope of the same arena (reading them from
+/// other threads is fine).
+template <typename T>
+struct ArenaAllocator
+{
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &) noexcept {}
+
+    auto allocate(std::size_t n) -> T *
+    {
+        static_assert(alignof(T) <= RequestArena::alignment, "ArenaAllocator: over-aligned type");
+        auto arena = internal::currentArena();
+        if (!arena)
+            throw std::logic_error("ArenaAllocator: allocation outside of an ArenaScope");
+        return static_cast<T *>(arena->allocate(n * sizeof(T)));
+    }
+
+    auto deallocate(T *ptr, std::size_t n) noexcept -> void
+    {
+        internal::currentArena()->deallocate(ptr, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+auto operator==(const ArenaAllocator<T> &, const ArenaAllocator<U> &) -> bool { return true; }
+
+template <typename T, typename U>
+auto operator!=(const ArenaAllocator<T> &, const ArenaAllocator<U> &) -> bool { return false; }
+
+/// JSON document allocating its objects and arrays from the arena of the current ArenaScope, for the
+/// data of a single request (the strings keep the heap)
+using arena_json = nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int64_t, std::uint64_t, double, ArenaAllocator>;
+
+} // namespace ThermoHubClient
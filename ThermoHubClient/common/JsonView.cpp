@@ -0,0 +1,365 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#include "JsonView.h"
+
+// C++ includes
+#include <algorithm>
+#include <cerrno>
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace ThermoHubClient
+{
+
+namespace
+{
+
+auto scanError(const std::string &what) -> std::runtime_error
+{
+    return std::runtime_error("JsonView: " + what);
+}
+
+auto isSpace(char c) -> bool
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+auto skipSpace(const char *pos, const char *end) -> const char *
+{
+    while (pos != end && isSpace(*pos))
+        ++pos;
+    return pos;
+}
+
+// position after the string starting at pos (at the opening quote)
+auto skipString(const char *pos, const char *end) -> const char *
+{
+    for (++pos; pos != end;)
+    {
+        auto quote = static_cast<const char *>(std::memchr(pos, '"', static_cast<std::size_t>(end - pos)));
+        if (!quote)
+            break;
+        // the quote ends the string unless an odd number of backslashes escapes it
+        auto escapes = quote;
+        while (escapes != pos && *(escapes - 1) == '\\')
+            --escapes;
+        if ((quote - escapes) % 2 == 0)
+            return quote + 1;
+        pos = quote + 1;
+    }
+    throw scanError("unterminated string");
+}
+
+// position after the value starting at pos
+auto skipValue(const char *pos, const char *end) -> const char *
+{
+    if (pos == end)
+        throw scanError("missing value");
+    if (*pos == '"')
+        return skipString(pos, end);
+    if (*pos == '{' || *pos == '[')
+    {
+        int depth = 0;
+        while (pos != end)
+        {
+            switch (*pos)
+            {
+            case '"':
+                pos = skipString(pos, end);
+                continue;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0)
+                    return pos + 1;
+                break;
+            default:
+                break;
+            }
+            ++pos;
+        }
+        throw scanError("unterminated object or array");
+    }
+    // number, true, false or null
+    auto start = pos;
+    while (pos != end && !isSpace(*pos) && *pos != ',' && *pos != '}' && *pos != ']' && *pos != ':')
+        ++pos;
+    if (pos == start)
+        throw scanError("unexpected character");
+    return pos;
+}
+
+// unescaped content of the string in [begin, end) including the quotes, the escapes are read by the json lexer
+auto unescape(const char *begin, const char *end) -> std::string
+{
+    if (std::find(begin + 1, end - 1, '\\') == end - 1)
+        return std::string(begin + 1, end - 1);
+    return json::parse(begin, end).get<std::string>();
+}
+
+// call f(keyBegin, keyEnd, value) for each member of the object in [first, last), the key with its quotes
+template <typename Function>
+auto scanMembers(const char *first, const char *last, Function f) -> void
+{
+    auto pos = skipSpace(first + 1, last);
+    if (pos != last && *pos == '}')
+        return;
+    while (pos != last)
+    {
+        if (*pos != '"')
+            throw scanError("expected an object key");
+        auto keyEnd = skipString(pos, last);
+        auto valueBegin = skipSpace(keyEnd, last);
+        if (valueBegin == last || *valueBegin != ':')
+            throw scanError("expected ':' after an object key");
+        valueBegin = skipSpace(valueBegin + 1, last);
+        auto valueEnd = skipValue(valueBegin, last);
+        f(pos, keyEnd, JsonView(valueBegin, valueEnd));
+        pos = skipSpace(valueEnd, last);
+        if (pos != last && *pos == ',')
+            pos = skipSpace(pos + 1, last);
+        else if (pos != last && *pos == '}')
+            return;
+        else
+            throw scanError("expected ',' or '}' in an object");
+    }
+    throw scanError("unterminated object");
+}
+
+// check if the integer in [begin, end) fits the 64 bit integers of the json lexer
+auto fitsInteger(const char *begin, const char *end, bool negative) -> bool
+{
+    auto digits = end - begin - (negative ? 1 : 0);
+    if (digits < (negative ? 19 : 20))
+        return true;
+    const std::string token(begin, end);
+    errno = 0;
+    if (negative)
+        std::strtoll(token.c_str(), nullptr, 10);
+    else
+        std::strtoull(token.c_str(), nullptr, 10);
+    return errno != ERANGE;
+}
+
+// append the number in [begin, end) as json::dump() writes the value parsed from it: the integers
+// of 64 bits as they are (-0 as 0), the other numbers as doubles in their shortest round-trip form
+auto appendNumber(std::string &out, const char *begin, const char *end) -> void
+{
+    const bool negative = *begin == '-';
+    if (std::none_of(begin, end, [](char c) { return c == '.' || c == 'e' || c == 'E'; }) && fitsInteger(begin, end, negative))
+    {
+        if (negative && end - begin == 2 && begin[1] == '0')
+            out += '0';
+        else
+            out.append(begin, end);
+        return;
+    }
+
+    // the json lexer reads the number with the decimal point of the locale
+    std::string token(begin, end);
+    const auto *locale = std::localeconv();
+    const char point = (locale->decimal_point == nullptr) ? '.' : *locale->decimal_point;
+    std::replace(token.begin(), token.end(), '.', point);
+    const auto value = std::strtod(token.c_str(), nullptr);
+    if (!std::isfinite(value))
+        throw scanError("number overflow " + std::string(begin, end));
+    char buffer[64];
+    out.append(buffer, nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer), value));
+}
+
+} // namespace
+
+JsonView::JsonView(const char *begin, const char *end)
+    : first(skipSpace(begin, end)), last(end)
+{
+    while (last != first && isSpace(*(last - 1)))
+        --last;
+}
+
+auto JsonView::document(const std::string &text) -> JsonView
+{
+    auto begin = text.data();
+    auto end = begin + text.size();
+    auto start = skipSpace(begin, end);
+    auto stop = skipValue(start, end);
+    if (skipSpace(stop, end) != end)
+        throw scanError("unexpected text after the document");
+    return JsonView(start, stop);
+}
+
+auto JsonView::isNull() const -> bool
+{
+    return last - first == 4 && std::memcmp(first, "null", 4) == 0;
+}
+
+auto JsonView::isString() const -> bool
+{
+    return !empty() && *first == '"';
+}
+
+auto JsonView::isObject() const -> bool
+{
+    return !empty() && *first == '{';
+}
+
+auto JsonView::isArray() const -> bool
+{
+    return !empty() && *first == '[';
+}
+
+auto JsonView::find(const std::string &key) const -> JsonView
+{
+    JsonView found;
+    if (!isObject())
+        return found;
+    scanMembers(first, last, [&](const char *keyBegin, const char *keyEnd, const JsonView &value) {
+        const auto size = static_cast<std::size_t>(keyEnd - keyBegin);
+        const bool same = std::find(keyBegin, keyEnd, '\\') != keyEnd
+                              ? unescape(keyBegin, keyEnd) == key
+                              : size == key.size() + 2 && std::memcmp(keyBegin + 1, key.data(), key.size()) == 0;
+        if (same)
+            found = value;
+    });
+    return found.isNull() ? JsonView() : found;
+}
+
+auto JsonView::members() const -> std::vector<std::pair<std::string, JsonView>>
+{
+    std::vector<std::pair<std::string, JsonView>> all;
+    if (!isObject())
+        return all;
+    scanMembers(first, last, [&](const char *keyBegin, const char *keyEnd, const JsonView &value) {
+        all.emplace_back(unescape(keyBegin, keyEnd), value);
+    });
+    auto byKey = [](const std::pair<std::string, JsonView> &a, const std::pair<std::string, JsonView> &b) { return a.first < b.first; };
+    if (!std::is_sorted(all.begin(), all.end(), byKey))
+        std::stable_sort(all.begin(), all.end(), byKey);
+
+    // the last of the members with the same key, as the json parser assigns them in turn
+    std::vector<std::pair<std::string, JsonView>> result;
+    result.reserve(all.size());
+    for (std::size_t i = 0; i < all.size(); ++i)
+        if ((i + 1 == all.size() || all[i + 1].first != all[i].first) && !all[i].second.isNull())
+            result.push_back(std::move(all[i]));
+    return result;
+}
+
+auto JsonView::elements() const -> std::vector<JsonView>
+{
+    std::vector<JsonView> result;
+    forEachElement([&](const JsonView &element) {
+        if (!element.isNull())
+            result.push_back(element);
+    });
+    return result;
+}
+
+auto JsonView::forEachElement(const std::function<void(const JsonView &)> &f) const -> void
+{
+    if (!isArray())
+        return;
+    auto pos = skipSpace(first + 1, last);
+    if (pos != last && *pos == ']')
+        return;
+    while (pos != last)
+    {
+        auto valueEnd = skipValue(pos, last);
+        f(JsonView(pos, valueEnd));
+        pos = skipSpace(valueEnd, last);
+        if (pos != last && *pos == ',')
+            pos = skipSpace(pos + 1, last);
+        else if (pos != last && *pos == ']')
+            return;
+        else
+            throw scanError("expected ',' or ']' in an array");
+    }
+    throw scanError("unterminated array");
+}
+
+auto JsonView::stringValue(const std::string &def) const -> std::string
+{
+    return isString() ? unescape(first, last) : def;
+}
+
+auto JsonView::appendTo(std::string &out) const -> void
+{
+    if (isObject())
+    {
+        out += '{';
+        bool firstMember = true;
+        for (const auto &member : members())
+        {
+            if (!firstMember)
+                out += ',';
+            firstMember = false;
+            appendString(out, member.first);
+            out += ':';
+            member.second.appendTo(out);
+        }
+        out += '}';
+    }
+    else if (isArray())
+    {
+        out += '[';
+        bool firstElement = true;
+        forEachElement([&](const JsonView &element) {
+            if (element.isNull())
+                return;
+            if (!firstElement)
+                out += ',';
+            firstElement = false;
+            element.appendTo(out);
+        });
+        out += ']';
+    }
+    else if (isString())
+    {
+        // the server escapes characters json::dump() writes as they are, such as '/'
+        if (std::find(first, last, '\\') == last)
+            out.append(first, last);
+        else
+            appendString(out, stringValue());
+    }
+    else if (!empty() && (*first == '-' || (*first >= '0' && *first <= '9')))
+        appendNumber(out, first, last);
+    else
+        out.append(first, last);
+}
+
+auto JsonView::appendString(std::string &out, const std::string &value) -> void
+{
+    auto escaped = [](char c) { return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20; };
+    if (std::none_of(value.begin(), value.end(), escaped))
+    {
+        out += '"';
+        out += value;
+        out += '"';
+    }
+    else
+        out += json(value).dump();
+}
+
+} // namespace ThermoHubClient
@@ -0,0 +1,80 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// C++ includes
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ThermoHubClient
+{
+
+/// View of a JSON value inside a text. The text is scanned on demand, no DOM is built:
+/// members and elements are located by skipping over the values that are not needed.
+/// Values are read as the DOM of the query results holds them: null object members and
+/// array elements are left out, and of duplicate keys the last member is used.
+class JsonView
+{
+public:
+    /// Empty view (no value)
+    JsonView() = default;
+
+    /// View of the JSON value in [begin, end), without surrounding whitespace
+    JsonView(const char *begin, const char *end);
+
+    /// View of the JSON document in text, throws if it is not a single JSON value
+    static auto document(const std::string &text) -> JsonView;
+
+    auto empty() const -> bool { return first == last; }
+    auto isNull() const -> bool;
+    auto isString() const -> bool;
+    auto isObject() const -> bool;
+    auto isArray() const -> bool;
+
+    /// The raw JSON text of the value
+    auto text() const -> std::string { return std::string(first, last); }
+
+    /// The member key of an object, empty view if not found, null or not an object
+    auto find(const std::string &key) const -> JsonView;
+
+    /// The members of an object ordered by key as in nlohmann::json, without null values
+    auto members() const -> std::vector<std::pair<std::string, JsonView>>;
+
+    /// The elements of an array, without null values
+    auto elements() const -> std::vector<JsonView>;
+
+    /// Call f(value) for each element of an array, null elements included
+    auto forEachElement(const std::function<void(const JsonView &)> &f) const -> void;
+
+    /// The unescaped value of a string, or def if the value is not a string
+    auto stringValue(const std::string &def = "") const -> std::string;
+
+    /// Append the value to out as nlohmann::json::dump() writes the parsed value: compact, with the members
+    /// ordered by key, null members and elements left out, and the numbers and strings written as by the DOM
+    auto appendTo(std::string &out) const -> void;
+
+    /// Append a JSON string of value to out, escaped as nlohmann::json::dump() does
+    static auto appendString(std::string &out, const std::string &value) -> void;
+
+private:
+    const char *first = nullptr;
+
+    const char *last = nullptr;
+};
+
+} // namespace ThermoHubClient
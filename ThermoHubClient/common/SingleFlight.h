@@ -0,0 +1,90 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "../RequestControl.h"
+
+// C++ includes
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace ThermoHubClient
+{
+
+/// Coalesces identical concurrent requests: while a request for a key is in flight, other
+/// threads asking for the same key wait for it and receive the same result (or exception)
+/// instead of starting their own. Result should be cheap to copy, e.g. a std::shared_ptr<const T>.
+/// A waiting thread stops waiting when its own cancellation token is cancelled, the fetch goes on
+/// for the others.
+template <typename Result>
+class SingleFlight
+{
+public:
+    /// Run fetch for key, or wait for the identical fetch already in flight until cancellation is cancelled
+    auto run(const std::string &key, const std::function<Result()> &fetch,
+             const CancellationToken *cancellation = nullptr) -> Result
+    {
+        std::promise<Result> promise;
+        std::shared_future<Result> result;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto itr = flights.find(key);
+            if (itr != flights.end())
+                result = itr->second;
+            else
+            {
+                result = promise.get_future().share();
+                flights.emplace(key, result);
+                leader = true;
+            }
+        }
+
+        if (leader)
+        {
+            try
+            {
+                promise.set_value(fetch());
+            }
+            catch (...)
+            {
+                promise.set_exception(std::current_exception());
+            }
+            // later requests start a new fetch
+            std::lock_guard<std::mutex> lock(mutex);
+            flights.erase(key);
+        }
+        else if (cancellation)
+        {
+            // check the token of the waiting request at short intervals
+            const auto cancellationInterval = std::chrono::milliseconds(20);
+            while (result.wait_for(cancellationInterval) != std::future_status::ready)
+                cancellation->throwIfCancelled();
+        }
+        return result.get();
+    }
+
+private:
+    std::mutex mutex;
+
+    std::map<std::string, std::shared_future<Result>> flights;
+};
+
+} // namespace ThermoHubClient
@@ -0,0 +1,205 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#include "ThreadPool.h"
+
+// C++ includes
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ThermoHubClient
+{
+
+using Task = std::function<void()>;
+
+struct ThreadPool::Impl
+{
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // one queue per worker
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    std::vector<std::thread> workers;
+
+    // queue receiving the next task, the tasks are spread over the queues
+    std::atomic<std::size_t> nextQueue{0};
+
+    // tasks in the queues
+    std::atomic<std::size_t> queued{0};
+
+    // guards sleeping workers and stop
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stop = false;
+
+    explicit Impl(std::size_t numThreads)
+    {
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        // the calling thread is one of the threads
+        for (std::size_t i = 0; i + 1 < numThreads; ++i)
+            queues.emplace_back(new Queue);
+        for (std::size_t i = 0; i < queues.size(); ++i)
+            workers.emplace_back([this, i]() { work(i); });
+    }
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    auto push(Task task) -> void
+    {
+        auto &queue = *queues[nextQueue++ % queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            ++queued;
+        }
+        wake.notify_one();
+    }
+
+    // take a task from the back of the own queue, or steal one from the front of another queue
+    // (the calling thread of parallelFor has no queue of its own, self == queues.size())
+    auto pop(std::size_t self, Task &task) -> bool
+    {
+        for (std::size_t k = 0; k < queues.size(); ++k)
+        {
+            auto i = (self + k) % queues.size();
+            auto &queue = *queues[i];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty())
+                continue;
+            if (i == self)
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            --queued;
+            return true;
+        }
+        return false;
+    }
+
+    auto work(std::size_t self) -> void
+    {
+        for (;;)
+        {
+            Task task;
+            if (pop(self, task))
+            {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this]() { return stop || queued > 0; });
+            if (stop && queued == 0)
+                return;
+        }
+    }
+};
+
+// chunks of one parallelFor still to be finished, guarded by mutex
+struct Batch
+{
+    std::size_t remaining = 0;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(std::size_t numThreads)
+    : pimpl(new Impl(numThreads))
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+}
+
+auto ThreadPool::size() const -> std::size_t
+{
+    return pimpl->workers.size() + 1;
+}
+
+auto ThreadPool::parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)> &body) -> void
+{
+    grain = std::max<std::size_t>(grain, 1);
+    const auto chunks = (count + grain - 1) / grain;
+    if (pimpl->workers.empty() || chunks <= 1)
+    {
+        if (count > 0)
+            body(0, count);
+        return;
+    }
+
+    Batch batch;
+    batch.remaining = chunks;
+    for (std::size_t begin = 0; begin < count; begin += grain)
+    {
+        auto end = std::min(begin + grain, count);
+        pimpl->push([&batch, &body, begin, end]() {
+            try
+            {
+                body(begin, end);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(batch.mutex);
+                if (!batch.error)
+                    batch.error = std::current_exception();
+            }
+            // the batch lives on the stack of parallelFor, it is not used after the unlock
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            if (--batch.remaining == 0)
+                batch.done.notify_all();
+        });
+    }
+
+    // work on the chunks until all are taken, then wait for the ones still running
+    Task task;
+    while (pimpl->pop(pimpl->queues.size(), task))
+        task();
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+
+    if (batch.error)
+        std::rethrow_exception(batch.error);
+}
+
+} // namespace ThermoHubClient
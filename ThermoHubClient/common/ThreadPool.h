@@ -0,0 +1,61 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+// C++ includes
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace ThermoHubClient
+{
+
+/// Work-stealing thread pool for data-parallel loops. Each worker has its own task queue:
+/// it takes tasks from the back of its queue and, when empty, steals from the front of the
+/// others. The thread calling parallelFor works on the tasks too until its loop is finished.
+class ThreadPool
+{
+public:
+    /// Pool running loops on numThreads threads (with the calling one), 0 for all hardware threads
+    explicit ThreadPool(std::size_t numThreads);
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /// Stop and join the workers
+    ~ThreadPool();
+
+    /// Number of threads running the loops, including the calling one
+    auto size() const -> std::size_t;
+
+    /**
+     * @brief Run body(begin, end) on the chunks of [0, count) and wait for all of them
+     *
+     * The chunks are at most grain indexes long and run in any order and thread, so body must only
+     * write to data of its own indexes. The first exception thrown by body is rethrown.
+     * @param count number of indexes
+     * @param grain maximum number of indexes of a chunk
+     * @param body function run on each chunk [begin, end)
+     */
+    auto parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)> &body) -> void;
+
+private:
+    struct Impl;
+
+    std::unique_ptr<Impl> pimpl;
+};
+
+} // namespace ThermoHubClient
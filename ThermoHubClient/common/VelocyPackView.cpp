@@ -0,0 +1,303 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "VelocyPackView.h"
+
+// C++ includes
+#include <cstring>
+
+namespace ThermoHubClient
+{
+
+namespace
+{
+
+auto decodeError(const std::string &what) -> std::runtime_error
+{
+    return std::runtime_error("VelocyPack: " + what);
+}
+
+// little-endian unsigned integer of width bytes
+auto readUnsigned(const std::uint8_t *pos, unsigned width) -> std::uint64_t
+{
+    std::uint64_t value = 0;
+    for (unsigned i = 0; i < width; ++i)
+        value |= static_cast<std::uint64_t>(pos[i]) << (8 * i);
+    return value;
+}
+
+// variable length integer, 7 bits per byte from the first, backwards from pos when reversed
+auto readVariable(const std::uint8_t *pos, const std::uint8_t *limit, bool reversed, std::size_t &length) -> std::uint64_t
+{
+    std::uint64_t value = 0;
+    for (length = 1;; ++length)
+    {
+        if (reversed ? pos < limit : pos >= limit)
+            throw decodeError("truncated length");
+        value |= static_cast<std::uint64_t>(*pos & 0x7f) << (7 * (length - 1));
+        if (!(*pos & 0x80) || length == 10)
+            return value;
+        pos += reversed ? -1 : 1;
+    }
+}
+
+// byte size of the value at pos (tags included), with the value checked to end before end
+auto valueSize(const std::uint8_t *pos, const std::uint8_t *end) -> std::size_t
+{
+    auto available = static_cast<std::size_t>(end - pos);
+    auto need = [&](std::size_t size) {
+        if (size > available)
+            throw decodeError("truncated value");
+        return size;
+    };
+    need(1);
+    const auto head = *pos;
+    switch (head)
+    {
+    case 0x01: case 0x0a: case 0x18: case 0x19: case 0x1a: case 0x1e: case 0x1f:
+        return 1;
+    case 0x1b: case 0x1c:
+        return need(9);
+    case 0x13: case 0x14:
+    {
+        std::size_t length = 0;
+        return need(readVariable(pos + 1, end, false, length));
+    }
+    case 0xbf:
+        need(9);
+        return need(9 + readUnsigned(pos + 1, 8));
+    case 0xee:
+        need(2);
+        return 2 + valueSize(pos + 2, end);
+    case 0xef:
+        need(9);
+        return 9 + valueSize(pos + 9, end);
+    default:
+        break;
+    }
+    if (head >= 0x02 && head <= 0x12 && head != 0x0a)
+    {
+        // arrays and objects with their byte length in 1, 2, 4 or 8 bytes
+        auto base = head >= 0x0f ? 0x0f : head >= 0x0b ? 0x0b : head >= 0x06 ? 0x06 : 0x02;
+        unsigned width = 1u << (head - base);
+        need(1 + width);
+        return need(readUnsigned(pos + 1, width));
+    }
+    if (head >= 0x20 && head <= 0x27)
+        return need(1 + head - 0x1f);
+    if (head >= 0x28 && head <= 0x2f)
+        return need(1 + head - 0x27);
+    if (head >= 0x30 && head <= 0x3f)
+        return 1;
+    if (head >= 0x40 && head <= 0xbe)
+        return need(1 + head - 0x40);
+    if (head >= 0xc0 && head <= 0xc7)
+    {
+        // binary data, with its length in 1 to 8 bytes
+        unsigned width = head - 0xbf;
+        need(1 + width);
+        return need(1 + width + readUnsigned(pos + 1, width));
+    }
+    throw decodeError("unsupported value type " + std::to_string(head));
+}
+
+} // namespace
+
+VelocyPackView::VelocyPackView(const char *begin, const char *end)
+    : VelocyPackView(reinterpret_cast<const std::uint8_t *>(begin), reinterpret_cast<const std::uint8_t *>(end))
+{
+}
+
+VelocyPackView::VelocyPackView(const std::uint8_t *begin, const std::uint8_t *end)
+    : start(begin), size(valueSize(begin, end)), first(begin)
+{
+    // the tags of a tagged value are skipped
+    while (*first == 0xee || *first == 0xef)
+        first += *first == 0xee ? 2 : 9;
+}
+
+auto VelocyPackView::isInteger() const -> bool
+{
+    return !empty() && (*first == 0x1c || (*first >= 0x20 && *first <= 0x3f));
+}
+
+auto VelocyPackView::isNegative() const -> bool
+{
+    if (!isInteger() || (*first >= 0x28 && *first <= 0x39))
+        return false;
+    if (*first >= 0x3a)
+        return true;
+    // signed integers and dates, the sign bit is in the last byte
+    unsigned width = *first == 0x1c ? 8 : *first - 0x1f;
+    return (first[width] & 0x80) != 0;
+}
+
+auto VelocyPackView::boolValue() const -> bool
+{
+    if (!isBool())
+        throw decodeError("not a bool");
+    return *first == 0x1a;
+}
+
+auto VelocyPackView::doubleValue() const -> double
+{
+    if (!isDouble())
+        throw decodeError("not a double");
+    // the bytes of the IEEE 754 double in little-endian order
+    auto bits = readUnsigned(first + 1, 8);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+auto VelocyPackView::intValue() const -> std::int64_t
+{
+    if (!isInteger())
+        throw decodeError("not an integer");
+    if (*first >= 0x30)
+        return *first <= 0x39 ? *first - 0x30 : static_cast<int>(*first) - 0x40;
+    if (*first >= 0x28)
+    {
+        auto value = uintValue();
+        if (value > static_cast<std::uint64_t>(INT64_MAX))
+            throw decodeError("integer out of range");
+        return static_cast<std::int64_t>(value);
+    }
+    unsigned width = *first == 0x1c ? 8 : *first - 0x1f;
+    auto value = readUnsigned(first + 1, width);
+    // sign extension of the width bytes
+    if (width < 8 && (value & (std::uint64_t(1) << (8 * width - 1))))
+        value |= ~std::uint64_t(0) << (8 * width);
+    return static_cast<std::int64_t>(value);
+}
+
+auto VelocyPackView::uintValue() const -> std::uint64_t
+{
+    if (!isInteger())
+        throw decodeError("not an integer");
+    if (*first >= 0x28 && *first <= 0x2f)
+        return readUnsigned(first + 1, *first - 0x27u);
+    auto value = intValue();
+    if (value < 0)
+        throw decodeError("negative integer");
+    return static_cast<std::uint64_t>(value);
+}
+
+auto VelocyPackView::stringValue() const -> std::string
+{
+    if (!isString())
+        throw decodeError("not a string");
+    if (*first == 0xbf)
+        return std::string(reinterpret_cast<const char *>(first) + 9, readUnsigned(first + 1, 8));
+    return std::string(reinterpret_cast<const char *>(first) + 1, *first - 0x40u);
+}
+
+auto VelocyPackView::keyValue() const -> std::string
+{
+    if (isString())
+        return stringValue();
+    // the attribute names ArangoDB translates to small numbers
+    if (isInteger() && !isNegative())
+    {
+        switch (uintValue())
+        {
+        case 1: return "_key";
+        case 2: return "_rev";
+        case 3: return "_id";
+        case 4: return "_from";
+        case 5: return "_to";
+        default: break;
+        }
+    }
+    throw decodeError("invalid object key");
+}
+
+auto VelocyPackView::find(const std::string &key) const -> VelocyPackView
+{
+    VelocyPackView found;
+    forEachMember([&](std::string &&name, const VelocyPackView &value) {
+        if (name == key)
+            found = value;
+    });
+    return found;
+}
+
+auto VelocyPackView::items() const -> Items
+{
+    Items layout;
+    const auto head = *first;
+    const auto valueEnd = end();
+    if (head == 0x01 || head == 0x0a)
+        return layout;
+    if (head == 0x13 || head == 0x14)
+    {
+        // byte length forwards after the head, item count backwards from the last byte
+        std::size_t lengthBytes = 0, countBytes = 0;
+        readVariable(first + 1, valueEnd, false, lengthBytes);
+        layout.count = readVariable(valueEnd - 1, first + 1 + lengthBytes, true, countBytes);
+        layout.data = first + 1 + lengthBytes;
+        return layout;
+    }
+
+    auto base = head >= 0x0f ? 0x0f : head >= 0x0b ? 0x0b : head >= 0x06 ? 0x06 : 0x02;
+    const unsigned width = 1u << (head - base);
+    const std::size_t byteLength = valueEnd - first;
+    if (base == 0x02)
+    {
+        // items of equal size without index table, after zero bytes of padding up to offset 9
+        std::size_t offset = 1 + width;
+        while (offset < 9 && offset < byteLength && first[offset] == 0)
+            offset = offset == 2 ? 3 : offset == 3 ? 5 : 9;
+        if (offset >= byteLength)
+            throw decodeError("empty array of items");
+        const auto itemSize = VelocyPackView(first + offset, valueEnd).size;
+        layout.count = (byteLength - offset) / itemSize;
+        layout.data = first + offset;
+        return layout;
+    }
+
+    // index table at the end, before the item count for 8 byte widths
+    layout.width = width;
+    if (width == 8)
+    {
+        if (byteLength < 17)
+            throw decodeError("truncated index table");
+        layout.count = readUnsigned(valueEnd - 8, 8);
+        if (layout.count > (byteLength - 17) / 8)
+            throw decodeError("truncated index table");
+        layout.index = valueEnd - 8 - 8 * layout.count;
+    }
+    else
+    {
+        if (byteLength < 1 + 2 * width)
+            throw decodeError("truncated index table");
+        layout.count = readUnsigned(first + 1 + width, width);
+        if (layout.count > (byteLength - 1 - 2 * width) / width)
+            throw decodeError("truncated index table");
+        layout.index = valueEnd - width * layout.count;
+    }
+    return layout;
+}
+
+auto VelocyPackView::readOffset(const Items &layout, std::size_t i) const -> std::size_t
+{
+    auto offset = readUnsigned(layout.index + i * layout.width, layout.width);
+    if (offset == 0 || offset >= static_cast<std::size_t>(end() - first))
+        throw decodeError("item offset out of range");
+    return offset;
+}
+
+} // namespace ThermoHubClient
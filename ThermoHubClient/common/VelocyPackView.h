@@ -0,0 +1,183 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+// C++ includes
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace ThermoHubClient
+{
+
+/// View of a VelocyPack value (the binary format of ArangoDB) inside a buffer. Nothing is copied:
+/// the items of arrays and objects are located through their index tables, or one after the other
+/// in the compact and the unindexed forms, and the scalars are read where they are. The value and
+/// every item read are checked to lie inside the buffer.
+class VelocyPackView
+{
+public:
+    /// Empty view (no value)
+    VelocyPackView() = default;
+
+    /// View of the value starting at begin, throws if it does not end before end
+    VelocyPackView(const char *begin, const char *end);
+
+    auto empty() const -> bool { return first == nullptr; }
+    auto isNull() const -> bool { return !empty() && *first == 0x18; }
+    auto isBool() const -> bool { return !empty() && (*first == 0x19 || *first == 0x1a); }
+    auto isDouble() const -> bool { return !empty() && *first == 0x1b; }
+    auto isString() const -> bool { return !empty() && *first >= 0x40 && *first <= 0xbf; }
+    auto isArray() const -> bool { return !empty() && ((*first >= 0x01 && *first <= 0x09) || *first == 0x13); }
+    auto isObject() const -> bool { return !empty() && ((*first >= 0x0a && *first <= 0x12) || *first == 0x14); }
+
+    /// Integers of any size, and UTC dates (milliseconds since the epoch)
+    auto isInteger() const -> bool;
+
+    /// Check if an integer is below zero
+    auto isNegative() const -> bool;
+
+    /// The bytes of the value, tags included
+    auto data() const -> const char * { return reinterpret_cast<const char *>(start); }
+    auto byteSize() const -> std::size_t { return size; }
+
+    auto boolValue() const -> bool;
+    auto doubleValue() const -> double;
+    auto intValue() const -> std::int64_t;
+    auto uintValue() const -> std::uint64_t;
+    auto stringValue() const -> std::string;
+
+    /// The member key of an object, empty view if not found or not an object
+    auto find(const std::string &key) const -> VelocyPackView;
+
+    /// Call f(value) for each element of an array
+    template <typename Function>
+    auto forEachElement(Function &&f) const -> void
+    {
+        if (!isArray())
+            return;
+        forEachItem([&](const std::uint8_t *item) { f(VelocyPackView(item, end())); });
+    }
+
+    /// Call f(key, value) for each member of an object, with the key as a std::string rvalue
+    template <typename Function>
+    auto forEachMember(Function &&f) const -> void
+    {
+        if (!isObject())
+            return;
+        forEachItem([&](const std::uint8_t *item) {
+            VelocyPackView key(item, end());
+            f(key.keyValue(), VelocyPackView(item + key.size, end()));
+        });
+    }
+
+private:
+    // the value with its tags, its size, and the value after the tags
+    const std::uint8_t *start = nullptr;
+    std::size_t size = 0;
+    const std::uint8_t *first = nullptr;
+
+    // layout of the items of an array or object
+    struct Items
+    {
+        std::size_t count = 0;
+        // the first item, the items follow each other when there is no index table
+        const std::uint8_t *data = nullptr;
+        // index table of item offsets from the value start, width bytes each
+        const std::uint8_t *index = nullptr;
+        unsigned width = 0;
+    };
+
+    VelocyPackView(const std::uint8_t *begin, const std::uint8_t *end);
+
+    auto end() const -> const std::uint8_t * { return start + size; }
+
+    auto items() const -> Items;
+
+    // the key of an object member, a string or the number of an attribute name translated by ArangoDB
+    auto keyValue() const -> std::string;
+
+    // call f(item) at the start of each item (each key of an object)
+    template <typename Function>
+    auto forEachItem(Function &&f) const -> void
+    {
+        const auto layout = items();
+        const auto *item = layout.data;
+        for (std::size_t i = 0; i < layout.count; ++i)
+        {
+            if (layout.index)
+                item = first + readOffset(layout, i);
+            f(item);
+            if (!layout.index)
+            {
+                item += VelocyPackView(item, end()).size;
+                // the value of an object member follows its key
+                if (isObject())
+                    item += VelocyPackView(item, end()).size;
+            }
+        }
+    }
+
+    auto readOffset(const Items &layout, std::size_t i) const -> std::size_t;
+};
+
+/// Decode a VelocyPack value into a DOM of any nlohmann::basic_json type, leaving out null object members
+/// and array items as the JSON query results are parsed; objectEnd(depth) is called after each object, the
+/// value decoded being at depth 0
+template <typename JsonType, typename Function>
+auto decodeVelocyPack(const VelocyPackView &value, Function &objectEnd, int depth = 0) -> JsonType
+{
+    if (value.isObject())
+    {
+        JsonType object = JsonType::object();
+        auto &members = object.template get_ref<typename JsonType::object_t &>();
+        value.forEachMember([&](std::string &&key, const VelocyPackView &member) {
+            if (member.isNull())
+                members.erase(key);
+            else
+                members[std::move(key)] = decodeVelocyPack<JsonType>(member, objectEnd, depth + 1);
+        });
+        objectEnd(depth);
+        return object;
+    }
+    if (value.isArray())
+    {
+        JsonType array = JsonType::array();
+        auto &elements = array.template get_ref<typename JsonType::array_t &>();
+        value.forEachElement([&](const VelocyPackView &element) {
+            if (!element.isNull())
+                elements.push_back(decodeVelocyPack<JsonType>(element, objectEnd, depth + 1));
+        });
+        return array;
+    }
+    if (value.isString())
+        return JsonType(value.stringValue());
+    if (value.isDouble())
+        return JsonType(value.doubleValue());
+    // the JSON parser reads the integers that are not negative as unsigned
+    if (value.isInteger())
+        return value.isNegative() ? JsonType(value.intValue()) : JsonType(value.uintValue());
+    if (value.isBool())
+        return JsonType(value.boolValue());
+    if (value.isNull())
+        return JsonType();
+    throw std::runtime_error("VelocyPack: a value of type " + std::to_string(static_cast<int>(*value.data())) + " has no JSON form");
+}
+
+} // namespace ThermoHubClient
@@ -0,0 +1,133 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#include "FormulaBatch.h"
+#include "FormulaScanner.h"
+#include "../common/ThreadPool.h"
+
+// C++ includes
+#include <algorithm>
+#include <string>
+
+namespace FormulaParser {
+
+namespace {
+
+// compositions of a chunk of formulas, with the periodic table ids and element_count + i
+// for the i-th symbol of the chunk not in the table
+struct Chunk
+{
+    std::vector<std::size_t> counts;
+    std::vector<int> elementIds;
+    std::vector<double> stoichiometries;
+    std::vector<int> valences;
+    std::vector<Symbol> symbols;
+    std::vector<std::pair<std::size_t, std::string>> errors;
+
+    // symbols out of the table are rare, found by a linear search
+    auto symbolId(const ScannedElement &entry) -> int
+    {
+        if (entry.id != no_element)
+            return entry.id;
+        auto itr = std::find(symbols.begin(), symbols.end(), entry.symbol);
+        if (itr == symbols.end())
+            itr = symbols.insert(symbols.end(), entry.symbol);
+        return element_count + static_cast<int>(itr - symbols.begin());
+    }
+};
+
+auto parseChunk(const std::string *formulas, std::size_t begin, std::size_t end, Chunk &chunk) -> void
+{
+    FormulaScanner scanner;
+    std::vector<ScannedElement> entries;
+    chunk.counts.reserve(end - begin);
+    for (auto i = begin; i < end; ++i)
+    {
+        const auto &formula = formulas[i];
+        if (!scanner.parse(formula.data(), formula.data() + formula.size(), entries))
+        {
+            chunk.errors.emplace_back(i, std::string(scanner.error()) + ": " + scanner.reason());
+            entries.clear();
+        }
+        chunk.counts.push_back(entries.size());
+        for (const auto &entry : entries)
+        {
+            chunk.elementIds.push_back(chunk.symbolId(entry));
+            chunk.stoichiometries.push_back(entry.stoich);
+            chunk.valences.push_back(entry.valence);
+        }
+    }
+}
+
+} // namespace
+
+auto parseMany(const std::string *formulas, std::size_t count, ThermoHubClient::ThreadPool *pool) -> FormulaCompositions
+{
+    const std::size_t threads = pool ? pool->size() : 1;
+    const std::size_t grain = threads > 1 ? std::max<std::size_t>(256, count / (8 * threads) + 1) : std::max<std::size_t>(count, 1);
+    std::vector<Chunk> chunks((count + grain - 1) / grain);
+    auto parseChunks = [&](std::size_t first, std::size_t end) {
+        for (auto c = first; c < end; ++c)
+            parseChunk(formulas, c * grain, std::min(count, (c + 1) * grain), chunks[c]);
+    };
+    if (pool)
+        pool->parallelFor(chunks.size(), 1, parseChunks);
+    else
+        parseChunks(0, chunks.size());
+
+    // ids of the symbols out of the table in the order of the sorted symbols
+    std::vector<Symbol> symbols;
+    std::size_t entries = 0;
+    for (const auto &chunk : chunks)
+    {
+        symbols.insert(symbols.end(), chunk.symbols.begin(), chunk.symbols.end());
+        entries += chunk.elementIds.size();
+    }
+    std::sort(symbols.begin(), symbols.end());
+    symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+
+    FormulaCompositions compositions;
+    compositions.elementSymbols.assign(element_symbols, element_symbols + element_count);
+    for (const auto &symbol : symbols)
+        compositions.elementSymbols.emplace_back(symbol.data());
+    compositions.offsets.reserve(count + 1);
+    compositions.offsets.push_back(0);
+    compositions.elementIds.reserve(entries);
+    compositions.stoichiometries.reserve(entries);
+    compositions.valences.reserve(entries);
+    compositions.errors.resize(count);
+    for (const auto &chunk : chunks)
+    {
+        std::vector<int> ids;
+        for (const auto &symbol : chunk.symbols)
+            ids.push_back(element_count + static_cast<int>(std::lower_bound(symbols.begin(), symbols.end(), symbol) - symbols.begin()));
+        for (auto n : chunk.counts)
+            compositions.offsets.push_back(compositions.offsets.back() + n);
+        for (auto id : chunk.elementIds)
+            compositions.elementIds.push_back(id < element_count ? id : ids[id - element_count]);
+        compositions.stoichiometries.insert(compositions.stoichiometries.end(), chunk.stoichiometries.begin(), chunk.stoichiometries.end());
+        compositions.valences.insert(compositions.valences.end(), chunk.valences.begin(), chunk.valences.end());
+        for (const auto &error : chunk.errors)
+            compositions.errors[error.first] = error.second;
+    }
+    return compositions;
+}
+
+auto parseMany(const std::vector<std::string> &formulas, ThermoHubClient::ThreadPool *pool) -> FormulaCompositions
+{
+    return parseMany(formulas.data(), formulas.size(), pool);
+}
+
+} // namespace FormulaParser
@@ -0,0 +1,77 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PeriodicTable.h"
+
+// C++ includes
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ThermoHubClient {
+class ThreadPool;
+}
+
+namespace FormulaParser {
+
+/// Compositions of many chemical formulas in one compressed sparse row buffer. The elements of
+/// formula i are the entries offsets[i] to offsets[i + 1], in the order of ChemicalFormulaParser::parse
+/// (by symbol and valence, the charge as element Zz); the isotope mass classes are not kept.
+struct FormulaCompositions
+{
+    /// Start of the entries of each formula, with the end of the last one (size() + 1 values)
+    std::vector<std::size_t> offsets;
+
+    /// Element of each entry, index in elementSymbols: the id of the periodic table (elementId) or,
+    /// for the symbols not in the table, element_count and above
+    std::vector<int> elementIds;
+
+    /// Stoichiometry coefficient of each entry
+    std::vector<double> stoichiometries;
+
+    /// Valence of each entry, -32768 if not given in the formula
+    std::vector<int> valences;
+
+    /// Symbols of the element ids: element_symbols followed by the sorted symbols found in the
+    /// formulas that are not in the table
+    std::vector<std::string> elementSymbols;
+
+    /// Parser error of each formula, empty if the formula was parsed (a failed formula has no entries)
+    std::vector<std::string> errors;
+
+    /// Number of formulas
+    auto size() const -> std::size_t { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    /// Check if formula i was parsed
+    auto parsed(std::size_t i) const -> bool { return errors[i].empty(); }
+};
+
+/**
+ * @brief Parse many chemical formulas into one FormulaCompositions
+ *
+ * The formulas are parsed as by ChemicalFormulaParser::parse, without allocations per formula and
+ * without exceptions: the errors are reported per formula.
+ * @param formulas first formula
+ * @param count number of formulas
+ * @param pool thread pool parsing chunks of the formulas in parallel (optional)
+ */
+auto parseMany(const std::string *formulas, std::size_t count, ThermoHubClient::ThreadPool *pool = nullptr) -> FormulaCompositions;
+
+/// Parse all formulas of a vector into one FormulaCompositions
+auto parseMany(const std::vector<std::string> &formulas, ThermoHubClient::ThreadPool *pool = nullptr) -> FormulaCompositions;
+
+} // namespace FormulaParser
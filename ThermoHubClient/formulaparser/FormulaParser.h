@@ -20,6 +20,7 @@
 #include <string>
 #include <list>
 #include <vector>
+#include "PeriodicTable.h"
 
 namespace FormulaParser {
 
@@ -71,48 +72,26 @@ struct Element
 {
     std::string symbol;
     std::string symbol_isotope;
+    int id;                   // id in element_symbols, no_element if not in the table
+    int isotope;              // isotope class of symbol_isotope
     int valence;              // valence IC
     double stoich;          // stoich. coef.
 
     Element( const char* aIck, const char* aIso, int aVal, double aStoc ):
-            symbol(aIck), symbol_isotope(aIso), valence(aVal), stoich(aStoc)
+            symbol(aIck), symbol_isotope(aIso), id(elementId(symbol)),
+            isotope(isotopeId(symbol_isotope)), valence(aVal), stoich(aStoc)
     {}
     Element( const Element& data ):
-            valence(data.valence), stoich(data.stoich)
+            id(data.id), isotope(data.isotope), valence(data.valence), stoich(data.stoich)
     {
         symbol = data.symbol;
         symbol_isotope = data.symbol_isotope;
     }
 };
 
-/// Parser for Chemical Formula
+/// Parser for Chemical Formula, the grammar is scanned by FormulaScanner
 class ChemicalFormulaParser : public BaseParser
 {
-    std::string formula;
-    std::string charge;
-
-    const char* CHARGE_TOK    ="+-@";
-
-    enum  CHARGE_FIELD
-    {
-      CHARGE_NUL    ='@',
-      CHARGE_PLUS   ='+',
-      CHARGE_MINUS  ='-'
-    };
-
-protected:
-
-    void icadd(  std::list<Element>& itt_, const char *icn,
-                 const char *iso, int val, double csto );
-    void icadd(  std::list<Element>& itt_, Element& it );
-    int  ictcomp( std::list<Element>::iterator& it, std::string& ick, int val );
-    void addCharge(std::list<Element>& tt);
-    void scanCharge();
-    void scanFterm( std::list<Element>& itt_, std::string& startPos, char endSimb );
-    void scanElem( std::list<Element>& itt_, std::string& cur );
-    void scanValence( int& val, std::string& cur);
-    void scanIsotope( std::string& isotop, std::string& cur);
-    void scanICsymb(  std::string& icName, std::string& cur);
 
 public:
 
@@ -0,0 +1,295 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "FormulaScanner.h"
+
+// C++ includes
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace FormulaParser {
+
+namespace {
+
+const int no_valence = -32768;
+
+auto isUpperCaseLetter(char ch) -> bool
+{
+    return (ch >= 'A' && ch <= 'Z') || ch == '$';
+}
+
+auto isLowerCaseLetter(char ch) -> bool
+{
+    return (ch >= 'a' && ch <= 'z') || ch == '_';
+}
+
+// order of the symbols of two elements, by id if both are in the periodic table
+auto compare(const ScannedElement &a, const ScannedElement &b) -> int
+{
+    if (a.id != no_element && b.id != no_element)
+        return a.id - b.id;
+    return a.symbol < b.symbol ? -1 : b.symbol < a.symbol ? 1 : 0;
+}
+
+// add an element to the sorted elements, summing the coefficients of the same symbol and valence
+// (the isotope class of the first one is kept)
+auto add(std::vector<ScannedElement> &elements, const ScannedElement &element) -> void
+{
+    auto itr = elements.begin();
+    for (; itr != elements.end(); ++itr)
+    {
+        auto order = compare(*itr, element);
+        if (order == 0 && itr->valence == element.valence)
+        {
+            itr->stoich += element.stoich;
+            return;
+        }
+        if (order > 0 || (order == 0 && itr->valence > element.valence))
+            break;
+    }
+    elements.insert(itr, element);
+}
+
+} // namespace
+
+auto makeSymbol(const char *begin, std::size_t length) -> Symbol
+{
+    Symbol symbol{};
+    std::memcpy(symbol.data(), begin, std::min(length, symbol.size() - 1));
+    return symbol;
+}
+
+// <formula> ::= <fterm> | <fterm><charge>, a charge token followed by | is a valence
+auto FormulaScanner::parse(const char *begin, const char *end, std::vector<ScannedElement> &elements) -> bool
+{
+    errorPart = nullptr;
+    errorReason = nullptr;
+
+    const char *charge = nullptr;
+    for (auto p = end; p != begin; --p)
+        if (p[-1] == '+' || p[-1] == '-' || p[-1] == '@')
+        {
+            if (std::find(p - 1, end, '|') == end)
+                charge = p - 1;
+            break;
+        }
+
+    cur = begin;
+    last = charge ? charge : end;
+    level(0).clear();
+    if (fterm(0, '\0') && charge)
+        addCharge(charge, end);
+    elements.assign(level(0).begin(), level(0).end());
+    return errorReason == nullptr;
+}
+
+auto FormulaScanner::level(std::size_t depth) -> std::vector<ScannedElement> &
+{
+    while (levels.size() <= depth)
+        levels.emplace_back();
+    return levels[depth];
+}
+
+auto FormulaScanner::fail(const char *part, const char *reason) -> bool
+{
+    errorPart = part;
+    errorReason = reason;
+    return false;
+}
+
+auto FormulaScanner::blanks() -> void
+{
+    while (cur < last && (*cur == ' ' || *cur == '\n' || *cur == '\t' || *cur == '\r'))
+        ++cur;
+}
+
+// <elem_st_coef> ::= <double>, read as std::stod
+auto FormulaScanner::real(double &value) -> bool
+{
+    blanks();
+    if (empty())
+        return true;
+    if (!std::isdigit(static_cast<unsigned char>(*cur)) && *cur != '.' && *cur != 'e')
+        return true;
+    char buffer[64];
+    auto length = std::min<std::size_t>(last - cur, sizeof(buffer) - 1);
+    std::memcpy(buffer, cur, length);
+    buffer[length] = '\0';
+    char *stop = nullptr;
+    errno = 0;
+    auto parsed = std::strtod(buffer, &stop);
+    if (stop == buffer || errno == ERANGE)
+        return fail("Formula", "Number scan error");
+    value = parsed;
+    cur += stop - buffer;
+    return true;
+}
+
+// <fterm> ::= <elem> | <elem><elem_st_coef> | <fterm><fterm>, into the elements of the depth
+auto FormulaScanner::fterm(std::size_t depth, char endSymbol) -> bool
+{
+    auto &elements = level(depth);
+    while (peek() != endSymbol && !empty())
+    {
+        auto &term = level(depth + 1);
+        term.clear();
+        if (!elem(depth + 1))
+            return false;
+
+        if (!empty())
+        {
+            double coef = 1.;
+            if (!real(coef))
+                return false;
+            for (auto &element : term)
+                element.stoich *= coef;
+        }
+
+        for (const auto &element : term)
+            add(elements, element);
+        blanks();
+        if (empty())
+            return true;
+    }
+    return true;
+}
+
+auto FormulaScanner::bracket(std::size_t depth, char close, const char *reason) -> bool
+{
+    ++cur;
+    if (!fterm(depth, close))
+        return false;
+    if (peek() != close)
+        return fail("Formula", reason);
+    ++cur;
+    return true;
+}
+
+// <elem> ::= (<fterm>) | [<fterm>] | {<fterm>} | <isotope_mass><icsymb><valence> |
+//            <isotope_mass><icsymb> | <icsymb><valence> | <icsymb>
+auto FormulaScanner::elem(std::size_t depth) -> bool
+{
+    blanks();
+    if (empty())
+        return true;
+
+    switch (peek())
+    {
+    case '(':
+        return bracket(depth, ')', "Must be )");
+    case '[':
+        return bracket(depth, ']', "Must be ]");
+    case '{':
+        return bracket(depth, '}', "Must be }");
+    case ':':
+        ++cur;
+        return true;
+    case 'V':
+        if (peek(1) == 'a') // Va - ignore vacancy
+        {
+            cur += 2;
+            return true;
+        }
+        // fall through, other <icsymb>
+    default:
+        break;
+    }
+
+    ScannedElement element{no_element, Symbol{}, makeSymbol("n", 1), no_valence, 1.};
+    if (!isotope(element.isotope) || !icsymb(element.symbol, element.id) || !scanValence(element.valence))
+        return false;
+    add(level(depth), element);
+    return true;
+}
+
+// <isotope_mass> ::= /<integer>/, e.g. /3/H2/18/O the isotopic form of water
+auto FormulaScanner::isotope(Symbol &isotope) -> bool
+{
+    blanks();
+    if (empty() || *cur != '/')
+        return true;
+    ++cur;
+    if (empty())
+        return fail("Isotope", "Term isotope scan error");
+    auto close = std::find(cur, last, '/');
+    if (close == last || close - cur >= 10)
+        return fail("Isotope", "Term isotope scan error");
+    isotope = makeSymbol(cur, static_cast<std::size_t>(close - cur));
+    cur = close + 1;
+    return true;
+}
+
+// <icsymb> ::= <Capital_letter> | <icsymb><lcase_letter> | <icsymb>_
+auto FormulaScanner::icsymb(Symbol &symbol, int &id) -> bool
+{
+    blanks();
+    if (empty())
+        return true;
+    if (!isUpperCaseLetter(*cur))
+        return fail("Fromula Parser", " A symbol of Element expected here!");
+    std::size_t i = 1;
+    for (; i <= 12; ++i)
+        if (!isLowerCaseLetter(peek(i)))
+            break;
+    if (i >= 10)
+        return fail("Fromula Parser", "IC Symbol scan error");
+    symbol = makeSymbol(cur, i);
+    id = elementId(cur, i);
+    cur += i;
+    return true;
+}
+
+// <valence> ::= |-<integer>| | |+<integer>| | |<integer>|
+auto FormulaScanner::scanValence(int &valence) -> bool
+{
+    blanks();
+    if (empty() || *cur != '|')
+        return true;
+    ++cur;
+    if (empty())
+        return fail("Valence", "Term valence scan error");
+    auto close = std::find(cur, last, '|');
+    if (close == last || close - cur >= 3)
+        return fail("Valence", "Term valence scan error");
+    char *stop = nullptr;
+    auto parsed = std::strtol(cur, &stop, 10);
+    if (stop == cur || stop > close)
+        return fail("Valence", "Integer number scan error");
+    valence = static_cast<int>(parsed);
+    cur = close + 1;
+    return true;
+}
+
+// <charge> ::= @ | +<double> | -<double>, added as element Zz
+auto FormulaScanner::addCharge(const char *charge, const char *end) -> void
+{
+    double cha = 1.0;
+    double aZ = 0.0;
+    if (*charge != '@')
+    {
+        cur = charge + 1;
+        last = end;
+        if (!real(cha))
+            return;
+        aZ = *charge == '-' ? -cha : cha;
+    }
+    add(level(0), ScannedElement{charge_element, makeSymbol("Zz", 2), makeSymbol("z", 1), 1, aZ});
+}
+
+} // namespace FormulaParser
@@ -0,0 +1,97 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "PeriodicTable.h"
+
+// C++ includes
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace FormulaParser {
+
+/// Element symbol or isotope class, zero padded (symbols have less than 10 characters): compares as std::string
+using Symbol = std::array<char, 12>;
+
+/// Symbol of length characters
+auto makeSymbol(const char *begin, std::size_t length) -> Symbol;
+
+/// Element of a formula scanned by FormulaScanner
+struct ScannedElement
+{
+    int id; // id in element_symbols, no_element if the symbol is not in the table
+    Symbol symbol;
+    Symbol isotope; // isotope mass class, "n" without isotope mass and "z" for the charge
+    int valence;
+    double stoich;
+};
+
+/// Scanner of the grammar of chemical formulas on a character range, used by ChemicalFormulaParser::parse
+/// and parseMany. It reuses its buffers between formulas and returns the errors instead of throwing them.
+class FormulaScanner
+{
+public:
+    /// Parse the formula into the elements, sorted by symbol and valence (the charge as element Zz),
+    /// false on an error described by error() and reason()
+    auto parse(const char *begin, const char *end, std::vector<ScannedElement> &elements) -> bool;
+
+    /// Part of the formula grammar that failed, e.g. "Valence"
+    auto error() const -> const char * { return errorPart; }
+
+    /// Reason of the failure
+    auto reason() const -> const char * { return errorReason; }
+
+private:
+    const char *cur = nullptr;
+    const char *last = nullptr;
+    const char *errorPart = nullptr;
+    const char *errorReason = nullptr;
+
+    // elements of the formula terms at each bracket depth; a deque keeps the references valid when it grows
+    std::deque<std::vector<ScannedElement>> levels;
+
+    auto level(std::size_t depth) -> std::vector<ScannedElement> &;
+
+    auto fail(const char *part, const char *reason) -> bool;
+
+    // character at offset k, '\0' past the end (as std::string::operator[] at size())
+    auto peek(std::size_t k = 0) const -> char { return cur + k < last ? cur[k] : '\0'; }
+
+    auto empty() const -> bool { return cur >= last; }
+
+    auto blanks() -> void;
+
+    auto real(double &value) -> bool;
+
+    auto fterm(std::size_t depth, char endSymbol) -> bool;
+
+    auto bracket(std::size_t depth, char close, const char *reason) -> bool;
+
+    auto elem(std::size_t depth) -> bool;
+
+    auto isotope(Symbol &isotope) -> bool;
+
+    auto icsymb(Symbol &symbol, int &id) -> bool;
+
+    auto scanValence(int &valence) -> bool;
+
+    auto addCharge(const char *charge, const char *end) -> void;
+};
+
+} // namespace FormulaParser
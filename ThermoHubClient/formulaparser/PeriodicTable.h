@@ -0,0 +1,141 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+// C++ includes
+#include <cstddef>
+#include <string>
+
+namespace FormulaParser {
+
+/// Number of element symbols in the table, the ids of the elements are 0 to element_count - 1
+constexpr int element_count = 119;
+
+/// Id of a symbol not in the table
+constexpr int no_element = -1;
+
+/// Symbols of the periodic table and the charge pseudo-element Zz, sorted as std::string:
+/// the ids (positions) of two symbols compare as the symbols
+constexpr const char *element_symbols[element_count] = {
+    "Ac", "Ag", "Al", "Am", "Ar", "As", "At", "Au", "B", "Ba", "Be", "Bh",
+    "Bi", "Bk", "Br", "C", "Ca", "Cd", "Ce", "Cf", "Cl", "Cm", "Cn", "Co",
+    "Cr", "Cs", "Cu", "Db", "Ds", "Dy", "Er", "Es", "Eu", "F", "Fe", "Fl",
+    "Fm", "Fr", "Ga", "Gd", "Ge", "H", "He", "Hf", "Hg", "Ho", "Hs", "I",
+    "In", "Ir", "K", "Kr", "La", "Li", "Lr", "Lu", "Lv", "Mc", "Md", "Mg",
+    "Mn", "Mo", "Mt", "N", "Na", "Nb", "Nd", "Ne", "Nh", "Ni", "No", "Np",
+    "O", "Og", "Os", "P", "Pa", "Pb", "Pd", "Pm", "Po", "Pr", "Pt", "Pu",
+    "Ra", "Rb", "Re", "Rf", "Rg", "Rh", "Rn", "Ru", "S", "Sb", "Sc", "Se",
+    "Sg", "Si", "Sm", "Sn", "Sr", "Ta", "Tb", "Tc", "Te", "Th", "Ti", "Tl",
+    "Tm", "Ts", "U", "V", "W", "Xe", "Y", "Yb", "Zn", "Zr", "Zz",
+};
+
+/// Isotope class of an element without isotope mass (NOISOTOPE_CLASS "n")
+constexpr int no_isotope = 0;
+
+/// Isotope class of the charge Zz (CHARGE_CLASS "z")
+constexpr int charge_isotope = -1;
+
+/// Isotope class that is neither a mass number nor one of the classes above
+constexpr int other_isotope = -2;
+
+namespace internal {
+
+// compare the symbol of length characters with a zero terminated table symbol, as std::string
+constexpr auto compareSymbol(const char *symbol, std::size_t length, const char *tableSymbol) -> int
+{
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        if (tableSymbol[i] == '\0' || tableSymbol[i] < symbol[i])
+            return 1;
+        if (tableSymbol[i] > symbol[i])
+            return -1;
+    }
+    return tableSymbol[length] == '\0' ? 0 : -1;
+}
+
+constexpr auto symbolsSorted() -> bool
+{
+    for (int i = 1; i < element_count; ++i)
+    {
+        std::size_t length = 0;
+        while (element_symbols[i][length] != '\0')
+            ++length;
+        if (compareSymbol(element_symbols[i], length, element_symbols[i - 1]) <= 0)
+            return false;
+    }
+    return true;
+}
+
+} // namespace internal
+
+/// Id of an element symbol of length characters, no_element if the symbol is not in the table
+constexpr auto elementId(const char *symbol, std::size_t length) -> int
+{
+    int first = 0;
+    int last = element_count;
+    while (first < last)
+    {
+        auto middle = first + (last - first) / 2;
+        auto order = internal::compareSymbol(symbol, length, element_symbols[middle]);
+        if (order == 0)
+            return middle;
+        if (order > 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return no_element;
+}
+
+/// Id of an element symbol, no_element if the symbol is not in the table
+inline auto elementId(const std::string &symbol) -> int
+{
+    return elementId(symbol.data(), symbol.size());
+}
+
+/// Id of the charge pseudo-element Zz
+constexpr int charge_element = elementId("Zz", 2);
+
+/// Isotope class of an isotope string of length characters: the mass number, no_isotope,
+/// charge_isotope or other_isotope
+constexpr auto isotopeId(const char *isotope, std::size_t length) -> int
+{
+    if (length == 1 && isotope[0] == 'n')
+        return no_isotope;
+    if (length == 1 && isotope[0] == 'z')
+        return charge_isotope;
+    int mass = 0;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        if (isotope[i] < '0' || isotope[i] > '9' || mass > 999)
+            return other_isotope;
+        mass = mass * 10 + (isotope[i] - '0');
+    }
+    return length > 0 && mass > 0 ? mass : other_isotope;
+}
+
+/// Isotope class of an isotope string
+inline auto isotopeId(const std::string &isotope) -> int
+{
+    return isotopeId(isotope.data(), isotope.size());
+}
+
+static_assert(internal::symbolsSorted(), "element_symbols must be sorted");
+static_assert(charge_element == element_count - 1 && elementId("H", 1) == 41 && elementId("Hx", 2) == no_element,
+              "element ids");
+
+} // namespace FormulaParser
@@ -26,6 +26,26 @@ if(NOT JSONARANGO_LIB)
   message(FATAL_ERROR "jsonarango library not found")
 endif()
 
+# Find the threads library (concurrent requests)
+find_package(Threads REQUIRED)
+
+#find_package(ZLIB REQUIRED)
+find_library(ZLIB_LIB NAMES z zlib)
+if(NOT ZLIB_LIB)
+  message(FATAL_ERROR "zlib library not found")
+endif()
+
+#find_package(zstd)
+find_library(ZSTD_LIB NAMES zstd libzstd)
+if(NOT ZSTD_LIB)
+  message(STATUS "zstd library not found - zstd compressed database files will not be supported")
+endif()
+
+# Find the realtime library (shared memory of the cache daemon on older glibc)
+if(UNIX AND NOT APPLE)
+  find_library(RT_LIB rt)
+endif()
+
 # Find pybind11 library (if needed)
 if(THERMOHUBCLIENT_BUILD_PYTHON)
     find_package(pybind11 REQUIRED)
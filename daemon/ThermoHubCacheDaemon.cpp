@@ -0,0 +1,90 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+//
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+// Cache daemon serving ThermoDataSets to the processes of a node:
+//
+//     thermohub-cache-daemon /run/thermohub.sock [hub-connection-config.json] [--workers N] [--ttl SECONDS]
+//
+// Clients use it by setting DatabaseClientOptions::cacheDaemonSocket to the socket path.
+// SIGHUP drops the ThermoDataSets held, the next requests download them again.
+
+#include <ThermoHubClient/CacheDaemon.h>
+
+// C++ includes
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+ThermoHubClient::CacheDaemon *daemon_instance = nullptr;
+
+extern "C" void stopDaemon(int)
+{
+    if (daemon_instance)
+        daemon_instance->stop();
+}
+
+extern "C" void reloadDaemon(int)
+{
+    if (daemon_instance)
+        daemon_instance->reload();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string socketPath, configuration;
+    ThermoHubClient::CacheDaemonOptions options;
+    bool usage = false;
+    for (int i = 1; i < argc && !usage; ++i)
+    {
+        if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+            options.workers = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--ttl") == 0 && i + 1 < argc)
+            options.timeToLiveSeconds = std::atoi(argv[++i]);
+        else if (socketPath.empty())
+            socketPath = argv[i];
+        else if (configuration.empty())
+            configuration = argv[i];
+        else
+            usage = true;
+    }
+    if (usage || socketPath.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " <socket path> [connection configuration file] [--workers N] [--ttl SECONDS]" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        ThermoHubClient::CacheDaemon daemon(socketPath, configuration, options);
+        daemon_instance = &daemon;
+        std::signal(SIGINT, stopDaemon);
+        std::signal(SIGTERM, stopDaemon);
+        std::signal(SIGHUP, reloadDaemon);
+        std::signal(SIGPIPE, SIG_IGN);
+        daemon.run();
+        daemon_instance = nullptr;
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+import json
+import os
+import sys
+import tempfile
+import threading
+import unittest
+
+import pytest as pytest
+import thermohubclient as client
+
+
+@pytest.mark.skipif(sys.platform.startswith("win"), reason="the cache daemon is only available on POSIX systems")
+class TestCacheDaemon(unittest.TestCase):
+
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.socket = os.path.join(self.directory.name, "thermohub.sock")
+        options = client.CacheDaemonOptions()
+        options.workers = 2
+        self.daemon = client.CacheDaemon(self.socket, "pytests/hub-connection-config.json", options)
+        self.thread = threading.Thread(target=self.daemon.run)
+        self.thread.start()
+
+        self.dbc = client.DatabaseClient("pytests/hub-connection-config.json")
+        self.daemon_dbc = client.DatabaseClient("pytests/hub-connection-config.json")
+        daemon_options = client.DatabaseClientOptions()
+        daemon_options.cacheDaemonSocket = self.socket
+        self.daemon_dbc.setOptions(daemon_options)
+
+    def tearDown(self):
+        self.daemon.stop()
+        self.thread.join()
+        self.directory.cleanup()
+
+    @staticmethod
+    def symbols(jsondata, name):
+        return sorted(record["symbol"] for record in json.loads(jsondata)[name])
+
+    def test_subset_from_daemon(self):
+        elements = ["Al", "Si", "O", "H", "Zz"]
+        direct = self.dbc.getDatabaseContainingElements("aq17", elements)
+        served = self.daemon_dbc.getDatabaseContainingElements("aq17", elements)
+        assert self.symbols(served, "elements") == self.symbols(direct, "elements")
+        assert self.symbols(served, "substances") == self.symbols(direct, "substances")
+        assert self.symbols(served, "reactions") == self.symbols(direct, "reactions")
+
+    def test_result_buffer_from_daemon(self):
+        result = self.daemon_dbc.getDatabaseResult("aq17", elements=["Ca", "C", "O", "H"])
+        assert json.loads(bytes(result)) == json.loads(str(result))
+
+    def test_concurrent_requests(self):
+        # more clients than workers, the waiting connections are served in turn
+        results = [None] * 8
+        errors = []
+
+        def request(i):
+            try:
+                dbc = client.DatabaseClient("pytests/hub-connection-config.json")
+                options = client.DatabaseClientOptions()
+                options.cacheDaemonSocket = self.socket
+                dbc.setOptions(options)
+                results[i] = dbc.getDatabaseContainingElements("aq17", ["Mg", "O", "H"])
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=request, args=(i,)) for i in range(len(results))]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        assert not errors
+        assert all(result == results[0] for result in results)
+
+    def test_reload(self):
+        before = self.daemon_dbc.getDatabaseContainingElements("aq17", ["Na", "Cl", "O", "H"])
+        self.daemon.reload()
+        after = self.daemon_dbc.getDatabaseContainingElements("aq17", ["Na", "Cl", "O", "H"])
+        assert after == before
+
+    def test_unknown_thermodataset(self):
+        with pytest.raises(Exception):
+            self.daemon_dbc.getDatabase("no-such-thermodataset")
@@ -1,7 +1,16 @@
+import gzip
+import json
+import os
+import sys
+import tempfile
 import thermohubclient as client
 import pytest as pytest
+import threading
 import unittest
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools"))
+from standin_server import RawJson, StandInServer  # noqa: E402
+
 
 class TestDatabaseClient(unittest.TestCase):
 
@@ -27,3 +36,237 @@ class TestDatabaseClient(unittest.TestCase):
         self.dbc.saveDatabase('aq17')
         self.dbc.saveDatabaseSubset('aq17', elements=["Al", "Si", "O", "Zz"])
 
+    def test_get_database_columns(self):
+        columns = self.dbc.getDatabaseColumns('aq17', elements=["Al", "Si", "O", "H", "Zz"])
+        substances = columns['substances']
+        assert substances.shape == (len(columns['substance_symbols']), len(columns['substance_properties']))
+        assert columns['reactions'].shape[0] == len(columns['reaction_symbols'])
+        row = columns['substance_index']['H2O@']
+        assert columns['substance_symbols'][row] == 'H2O@'
+
+    def test_shared_client_in_threads(self):
+        # requests and setOptions of one client from several threads run one at a time
+        expected = self.dbc.getDatabaseContainingElements('aq17', ["Ca", "C", "O", "H"])
+        results = []
+        errors = []
+
+        def request():
+            try:
+                options = client.DatabaseClientOptions()
+                self.dbc.setOptions(options)
+                results.append(self.dbc.getDatabaseContainingElements('aq17', ["Ca", "C", "O", "H"]))
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=request) for _ in range(6)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        assert not errors
+        assert results == [expected] * len(threads)
+
+
+def thermodataset(substances, elements=None):
+    return json.dumps({"elements": elements or [{"symbol": "O"}, {"symbol": "H"}], "substances": substances, "reactions": []})
+
+
+class TestDatabaseFiles(unittest.TestCase):
+    """Database files and ThermoDataSet versions, without the server"""
+
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+
+    def tearDown(self):
+        self.directory.cleanup()
+
+    def path(self, name):
+        return os.path.join(self.directory.name, name)
+
+    def test_database_file_round_trip(self):
+        jsondata = thermodataset([{"symbol": f"S{i}", "formula": "H2O@", "sm_volume": {"values": [i * 0.5]}} for i in range(2000)])
+        for suffix, magic in [(".json", b"{"), (".json.gz", b"\x1f\x8b"), (".json.zst", b"\x28\xb5\x2f\xfd")]:
+            fileName = self.path("aq17" + suffix)
+            try:
+                client.writeDatabaseFile(fileName, jsondata)
+            except Exception as e:
+                if suffix == ".json.zst" and "zstd" in str(e):
+                    continue  # built without zstd support
+                raise
+            assert client.readDatabaseFile(fileName) == jsondata
+            with open(fileName, "rb") as f:
+                assert f.read(len(magic)) == magic
+            if suffix != ".json":
+                assert os.path.getsize(fileName) < len(jsondata)
+        with gzip.open(self.path("aq17.json.gz"), "rt") as f:
+            assert f.read() == jsondata
+
+    def test_read_missing_database_file(self):
+        with pytest.raises(Exception):
+            client.readDatabaseFile(self.path("missing.json"))
+
+    def test_canonical_record_hash(self):
+        # the order of the properties, null properties, white space and the writing of the numbers do not matter
+        before = thermodataset([{"symbol": "A", "formula": "H2O@", "charge": 0, "values": [1, 2.5]}])
+        after = thermodataset([{"values": [1.0, 2.50], "formula": "H2O@", "symbol": "A", "charge": -0.0, "comment": None}])
+        diff = client.diffThermoDataSets(client.hashThermoDataSetText(before), client.hashThermoDataSetText(after))
+        assert diff["substances"] == {"added": [], "removed": [], "modified": [], "duplicated": []}
+        changed = thermodataset([{"symbol": "A", "formula": "H2O@", "charge": 0, "values": [1, 2.6]}])
+        diff = client.diffThermoDataSets(client.hashThermoDataSetText(before), client.hashThermoDataSetText(changed))
+        assert diff["substances"]["modified"] == ["A"]
+
+    def test_diff_database_files(self):
+        before = thermodataset([{"symbol": "A", "x": 1}, {"symbol": "B", "x": 2}, {"symbol": "C", "x": 3}])
+        after = thermodataset([{"symbol": "D", "x": 4}, {"symbol": "C", "x": 3}, {"symbol": "A", "x": 10}],
+                              elements=[{"symbol": "O"}, {"symbol": "H"}, {"symbol": "Ca"}])
+        client.writeDatabaseFile(self.path("before.json"), before)
+        client.writeDatabaseFile(self.path("after.json.gz"), after)
+        # the files are streamed one record at a time, with the same result as the hashes of the texts
+        diff = client.diffDatabaseFiles(self.path("before.json"), self.path("after.json.gz"))
+        assert diff == client.diffThermoDataSets(client.hashThermoDataSetText(before), client.hashThermoDataSetText(after))
+        assert diff["substances"] == {"added": ["D"], "removed": ["B"], "modified": ["A"], "duplicated": []}
+        assert diff["elements"] == {"added": ["Ca"], "removed": [], "modified": [], "duplicated": []}
+        assert len(client.hashDatabaseFile(self.path("after.json.gz"))) == 6
+
+    def test_diff_duplicated_symbols(self):
+        before = thermodataset([{"symbol": "A", "x": 1}, {"symbol": "A", "x": 2}, {"symbol": "B", "x": 1}])
+        same = thermodataset([{"symbol": "A", "x": 2}, {"symbol": "A", "x": 1}, {"symbol": "B", "x": 1}])
+        fewer = thermodataset([{"symbol": "A", "x": 1}, {"symbol": "B", "x": 1}, {"symbol": "B", "x": 1}])
+        hashes = client.hashThermoDataSetText(before)
+        # the records of a duplicated symbol are compared in any order, and are reported
+        diff = client.diffThermoDataSets(hashes, client.hashThermoDataSetText(same))
+        assert diff["substances"] == {"added": [], "removed": [], "modified": [], "duplicated": ["A"]}
+        diff = client.diffThermoDataSets(hashes, client.hashThermoDataSetText(fewer))
+        assert diff["substances"] == {"added": [], "removed": [], "modified": ["A", "B"], "duplicated": ["A", "B"]}
+
+    def test_loaded_thermodataset_reactions(self):
+        reactions = [
+            {"symbol": "H2O@", "reactants": [{"symbol": "H2O@", "coefficient": -1}, {"symbol": "H+", "coefficient": 1}, {"symbol": "OH-", "coefficient": 1}]},
+            {"symbol": "OH-", "reactants": [{"symbol": "OH-", "coefficient": -1}, {"symbol": "H2O@", "coefficient": 1}, {"symbol": "H+", "coefficient": -1}]},
+            {"symbol": "CaCO3@ dissociation", "reactants": [{"symbol": "CaCO3@", "coefficient": -1}, {"symbol": "Ca+2", "coefficient": 1},
+                                                            {"symbol": "CO3-2", "coefficient": 1}]},
+        ]
+        substances = [
+            {"symbol": "H2O@", "formula": "H2O@", "reaction": "H2O@", "class_": {"3": "SC_AQSOLVENT"}},
+            {"symbol": "OH-", "formula": "OH-", "reaction": "OH-", "class_": {"2": "SC_AQSOLUTE"}},
+            {"symbol": "CaCO3@", "formula": "CaCO3@", "class_": {"2": "SC_AQSOLUTE"}},
+            {"symbol": "Ca+2", "formula": "Ca+2", "class_": {"2": "SC_AQSOLUTE"}},
+        ]
+        jsondata = json.dumps({"elements": [{"symbol": e} for e in ["C", "Ca", "H", "O"]], "substances": substances, "reactions": reactions})
+        client.writeDatabaseFile(self.path("test.json"), jsondata)
+        dbc = client.DatabaseClient()
+        dbc.loadThermoDataSet("test", self.path("test.json"))
+
+        def reactionSymbols(jsondata):
+            return [record["symbol"] for record in json.loads(jsondata)["reactions"]]
+
+        # all reactions without a selection of substances
+        assert reactionSymbols(dbc.getDatabase("test")) == ["H2O@", "OH-", "CaCO3@ dissociation"]
+        # the reaction property, the reactants for the reactions no reaction property refers to
+        assert reactionSymbols(dbc.getDatabaseSubset("test", substances=["H2O@"])) == ["H2O@"]
+        assert reactionSymbols(dbc.getDatabaseSubset("test", substances=["CaCO3@"])) == ["CaCO3@ dissociation"]
+        assert reactionSymbols(dbc.getDatabaseSubset("test", substances=["Ca+2", "OH-"])) == ["OH-", "CaCO3@ dissociation"]
+        assert reactionSymbols(dbc.getDatabaseSubset("test", classesOfSubstance=['{"3":"SC_AQSOLVENT"}'])) == ["H2O@"]
+
+
+class TestElementSelection(unittest.TestCase):
+    """Selection by elements of the server results on several threads, against a stand-in server"""
+
+    def setUp(self):
+        formulas = ["H2O@", "CaCO3", "NaCl", "SiO2", "Al2O3", "OH-", "Ca+2", "Mg+2", "KCl", "FeO", "CO2@", "NaOH"]
+        substances = [{"symbol": f"S{i:05d}", "formula": formulas[i % len(formulas)], "reaction": f"R{i:05d}"} for i in range(3000)]
+        reactions = [{"symbol": f"R{i:05d}", "reactants": [{"symbol": f"S{i:05d}", "coefficient": -1},
+                                                           {"symbol": f"S{(i * 7) % 3000:05d}", "coefficient": 1}]} for i in range(3000)]
+        elements = [{"symbol": e} for e in ["Al", "C", "Ca", "Cl", "Fe", "H", "K", "Mg", "Na", "O", "Si"]]
+        self.directory = tempfile.TemporaryDirectory()
+        self.server = StandInServer({"large": {"elements": elements, "substances": substances, "reactions": reactions}}).start()
+        self.config = self.server.writeConfig(os.path.join(self.directory.name, "connection-config.json"))
+
+    def tearDown(self):
+        self.server.stop()
+        self.directory.cleanup()
+
+    def test_threads_select_as_one(self):
+        results = []
+        for numThreads in [1, 4]:
+            dbc = client.DatabaseClient(self.config)
+            options = client.DatabaseClientOptions()
+            options.numThreads = numThreads
+            dbc.setOptions(options)
+            results.append(dbc.getDatabaseContainingElements("large", ["Ca", "C", "O", "H"]))
+        assert results[1] == results[0]
+        selected = json.loads(results[0])
+        assert 0 < len(selected["reactions"]) < 3000
+        assert len(selected["substances"]) == 1250
+
+
+class TestTextSelection(unittest.TestCase):
+    """Compact results selected by elements on the query text, against the results of the parsed ThermoDataSet"""
+
+    def setUp(self):
+        # numbers in the notations of the server, nulls, escaped '/' and non-ASCII text
+        substances = [
+            {"symbol": "Ca+2", "formula": "Ca+2", "name": "Ca²⁺ ion", "reaction": None,
+             "sm_gibbs_energy": {"values": [RawJson("-5.5296E+5"), RawJson("-0")], "units": ["J/mol"]}, "datasources": ["CODATA/NBS", None]},
+            {"symbol": "CO2@", "formula": "CO2@", "reaction": "CO2@",
+             "sm_heat_capacity_p": {"values": [RawJson("243.1e-1"), RawJson("18446744073709551616"), RawJson("1.0")]}},
+            {"symbol": "Na+", "formula": "Na+", "reaction": "NaCO2", "sm_gibbs_energy": {"values": [RawJson("-261881.0")]}},
+            {"symbol": "H2O@", "formula": "H2O@", "name": "water \"liquid\"\ttab",
+             "sm_gibbs_energy": {"values": [RawJson("-237181.38"), 12345678901234567890, RawJson("-9223372036854775809")]}},
+        ]
+        reactions = [
+            {"symbol": "CO2@", "equation": "CO2@ = Ca+2 / 2", "logKr": {"values": [RawJson("1E1"), RawJson("0.10000000000000001")]},
+             "reactants": [{"symbol": "CO2@", "coefficient": -1}, {"symbol": "Ca+2", "coefficient": RawJson("1.0")}]},
+            {"symbol": "NaCO2", "reactants": [{"symbol": "Na+", "coefficient": 1}, {"symbol": "CO2@", "coefficient": -1}]},
+        ]
+        elements = [{"symbol": e, "atomic_mass": {"values": [RawJson("4.0078E1")]}} for e in ["C", "Ca", "H", "Na", "O"]]
+        self.directory = tempfile.TemporaryDirectory()
+        self.server = StandInServer({"text": {"elements": elements, "substances": substances, "reactions": reactions}}).start()
+        self.config = self.server.writeConfig(os.path.join(self.directory.name, "connection-config.json"))
+        self.cwd = os.getcwd()
+        os.chdir(self.directory.name)
+
+    def tearDown(self):
+        os.chdir(self.cwd)
+        self.server.stop()
+        self.directory.cleanup()
+
+    def databaseClient(self, **values):
+        dbc = client.DatabaseClient(self.config)
+        options = client.DatabaseClientOptions()
+        options.json_indent_save = -1
+        for name, value in values.items():
+            setattr(options, name, value)
+        dbc.setOptions(options)
+        return dbc
+
+    def test_text_selection_as_parsed(self):
+        elements = ["Ca", "C", "O", "H"]
+        for selectedProperties in [[], ["formula", "name", "sm_gibbs_energy", "logKr"]]:
+            text = self.databaseClient(selectedProperties=selectedProperties).getDatabaseContainingElements("text", elements)
+
+            # the saved file and the cached ThermoDataSet are selected on the parsed data
+            dbc = self.databaseClient(selectedProperties=selectedProperties)
+            dbc.saveDatabaseContainingElements("text", elements)
+            with open("text-subset-thermofun.json", encoding="utf-8") as file:
+                assert text == file.read()
+            assert text == self.databaseClient(selectedProperties=selectedProperties, cacheThermoDataSets=True).getDatabaseContainingElements("text", elements)
+
+        selected = json.loads(text)
+        assert [record["symbol"] for record in selected["substances"]] == ["CO2@", "Ca+2", "H2O@"]
+        assert [record["symbol"] for record in selected["reactions"]] == ["CO2@"]
+        assert selected["substances"][1]["sm_gibbs_energy"]["values"] == [-552960.0, 0]
+
+    def test_velocypack_transport_as_json(self):
+        elements = ["Ca", "C", "O", "H"]
+        for selectedProperties in [[], ["formula", "name", "sm_gibbs_energy", "logKr"]]:
+            complete = self.databaseClient(selectedProperties=selectedProperties).getDatabase("text")
+            selected = self.databaseClient(selectedProperties=selectedProperties).getDatabaseContainingElements("text", elements)
+            assert "application/x-velocypack" not in self.server.accepted[-1]
+
+            dbc = self.databaseClient(selectedProperties=selectedProperties, velocypackTransport=True)
+            assert dbc.getDatabase("text") == complete
+            assert dbc.getDatabaseContainingElements("text", elements) == selected
+            assert "application/x-velocypack" in self.server.accepted[-1]
+            cached = self.databaseClient(selectedProperties=selectedProperties, velocypackTransport=True, cacheThermoDataSets=True)
+            assert cached.getDatabaseContainingElements("text", elements) == selected
@@ -0,0 +1,169 @@
+import json
+import math
+import os
+import tempfile
+import unittest
+
+import thermohubclient as client
+
+
+def element(symbol, atomic_mass):
+    return {"symbol": symbol, "atomic_mass": {"values": [atomic_mass]}}
+
+
+def substance(symbol, formula, mass_per_mole, formula_charge, reaction=""):
+    return {"symbol": symbol, "formula": formula, "mass_per_mole": {"values": [mass_per_mole]},
+            "formula_charge": {"values": [formula_charge]}, "reaction": reaction}
+
+
+def reaction(symbol, reactants):
+    return {"symbol": symbol, "reactants": [{"symbol": s, "coefficient": c} for s, c in reactants]}
+
+
+# a small ThermoDataSet with an element that is not in the periodic table (Xx)
+THERMODATASET = {
+    "elements": [element("Ca", 40.078), element("C", 12.011), element("O", 15.999), element("H", 1.008),
+                 element("Fe", 55.845), element("Xx", 10.0), element("Zz", 0.0)],
+    "substances": [
+        substance("Ca+2", "Ca+2", 40.078, 2),
+        substance("CO3-2", "CO3-2", 60.008, -2),
+        substance("Calcite", "CaCO3", 100.086, 0, "Calcite"),
+        substance("H+", "H+", 1.008, 1),
+        substance("OH-", "OH-", 17.007, -1),
+        substance("H2O@", "H2O@", 18.015, 0, "H2O@"),
+        substance("Portlandite", "Ca(OH)2", 74.092, 0),
+        substance("Hematite", "Fe|3|2O3", 159.687, 0),
+        substance("Magnetite", "Fe|2|Fe|3|2O4", 231.531, 0),
+        substance("XxO", "XxO", 25.999, 0),
+        substance("H2O-18", "H2/18/O", 18.015, 0),
+    ],
+    "reactions": [
+        reaction("Calcite", [("Calcite", -1), ("Ca+2", 1), ("CO3-2", 1)]),
+        reaction("H2O@", [("H2O@", -1), ("H+", 1), ("OH-", 1)]),
+        reaction("Unbalanced", [("Ca+2", -1), ("H+", 1)]),
+        reaction("Unknown", [("Calcite", -1), ("Aragonite", 1)]),
+    ],
+}
+
+
+class TestFormulas(unittest.TestCase):
+    """Formula analysis of ThermoDataSets loaded from database files, without the server"""
+
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.dbc = client.DatabaseClient()
+
+    def tearDown(self):
+        self.directory.cleanup()
+
+    def load(self, thermodataset, name="test"):
+        fileName = os.path.join(self.directory.name, name + ".json")
+        client.writeDatabaseFile(fileName, json.dumps(thermodataset))
+        self.dbc.loadThermoDataSet(name, fileName)
+        return name
+
+    def column(self, matrix, symbol):
+        j = matrix["substance_index"][symbol]
+        return {e: matrix["matrix"][i][j] for i, e in enumerate(matrix["elements"]) if matrix["matrix"][i][j] != 0}
+
+    def test_formula_matrix_elements(self):
+        matrix = self.dbc.getFormulaMatrix(self.load(THERMODATASET))
+        assert matrix["elements"] == ["Ca", "C", "O", "H", "Fe", "Xx", "Zz"]
+        assert matrix["substances"] == [s["symbol"] for s in THERMODATASET["substances"]]
+        assert self.column(matrix, "Calcite") == {"Ca": 1, "C": 1, "O": 3}
+        assert self.column(matrix, "Portlandite") == {"Ca": 1, "O": 2, "H": 2}
+        assert self.column(matrix, "CO3-2") == {"C": 1, "O": 3, "Zz": -2}
+        assert self.column(matrix, "H2O@") == {"O": 1, "H": 2}
+        # the valences of an element are summed, the isotope classes are left out
+        assert self.column(matrix, "Hematite") == {"Fe": 2, "O": 3}
+        assert self.column(matrix, "Magnetite") == {"Fe": 3, "O": 4}
+        assert self.column(matrix, "H2O-18") == {"H": 2, "O": 1}
+        # a symbol out of the periodic table is an element as the others
+        assert self.column(matrix, "XxO") == {"Xx": 1, "O": 1}
+
+    def test_formula_matrix_without_charge(self):
+        matrix = self.dbc.getFormulaMatrix(self.load(THERMODATASET), chargeRow=False)
+        assert "Zz" not in matrix["elements"]
+        assert self.column(matrix, "Ca+2") == {"Ca": 1}
+
+    def test_formula_matrix_sparse(self):
+        name = self.load(THERMODATASET)
+        dense = self.dbc.getFormulaMatrix(name)
+        sparse = self.dbc.getFormulaMatrix(name, dense=False)
+        assert sparse["shape"] == dense["shape"]
+        rows, cols = sparse["shape"]
+        for i in range(rows):
+            row = [0.0] * cols
+            for k in range(sparse["indptr"][i], sparse["indptr"][i + 1]):
+                row[sparse["indices"][k]] = sparse["data"][k]
+            assert row == list(dense["matrix"][i])
+
+    def test_formula_matrix_failed_columns(self):
+        substances = THERMODATASET["substances"] + [substance("Quartz", "SiO2", 60.084, 0),
+                                                    substance("Broken", "Ca(OH", 0.0, 0)]
+        matrix = self.dbc.getFormulaMatrix(self.load(dict(THERMODATASET, substances=substances)))
+        # the substances with an element that is not in the ThermoDataSet or a formula that is not parsed
+        # have empty columns, the other columns are filled
+        assert matrix["failed_substances"] == ["Quartz", "Broken"]
+        assert len(matrix["failures"]) == 2
+        assert "Si" in matrix["failures"][0]
+        assert self.column(matrix, "Quartz") == {}
+        assert self.column(matrix, "Broken") == {}
+        assert self.column(matrix, "Calcite") == {"Ca": 1, "C": 1, "O": 3}
+
+    def test_formula_matrix_without_failures(self):
+        matrix = self.dbc.getFormulaMatrix(self.load(THERMODATASET))
+        assert matrix["failed_substances"] == []
+        assert matrix["failures"] == []
+
+    def test_reaction_matrix(self):
+        matrix = self.dbc.getReactionMatrix(self.load(THERMODATASET))
+        assert matrix["reactions"] == ["Calcite", "H2O@", "Unbalanced", "Unknown"]
+        row = matrix["matrix"][matrix["reaction_index"]["Calcite"]]
+        assert row[matrix["substance_index"]["Calcite"]] == -1
+        assert row[matrix["substance_index"]["Ca+2"]] == 1
+        assert row[matrix["substance_index"]["CO3-2"]] == 1
+        assert sum(row != 0) == 3
+        assert matrix["unknown_reactants"][matrix["reaction_index"]["Unknown"]] == ["Aragonite"]
+
+    def test_reaction_balance(self):
+        balance = self.dbc.checkReactionBalance(self.load(THERMODATASET))
+        assert balance["unbalanced"] == ["Unbalanced", "Unknown"]
+        residuals = balance["residuals"][balance["reactions"].index("Unbalanced")]
+        assert residuals[balance["elements"].index("Ca")] == -1
+        assert residuals[balance["elements"].index("H")] == 1
+        assert residuals[balance["elements"].index("Zz")] == -1
+
+    def test_reaction_balance_failed_formula(self):
+        # the silica substances fail (Si is not an element of the ThermoDataSet): their empty columns
+        # give zero residuals, but a reaction using them cannot be checked and is unbalanced
+        substances = THERMODATASET["substances"] + [substance("Quartz", "SiO2", 60.084, 0, "Quartz"),
+                                                    substance("SiO2@", "SiO2@", 60.084, 0)]
+        reactions = THERMODATASET["reactions"] + [reaction("Quartz", [("Quartz", -1), ("SiO2@", 1)])]
+        balance = self.dbc.checkReactionBalance(self.load(dict(THERMODATASET, substances=substances, reactions=reactions)))
+        assert balance["unbalanced"] == ["Unbalanced", "Unknown", "Quartz"]
+        assert not balance["residuals"][balance["reactions"].index("Quartz")].any()
+
+    def test_molar_mass_charge(self):
+        values = self.dbc.getMolarMassCharge(self.load(THERMODATASET))
+        assert values["substances"] == [s["symbol"] for s in THERMODATASET["substances"]]
+        for s in THERMODATASET["substances"]:
+            i = values["substance_index"][s["symbol"]]
+            assert math.isclose(values["molar_mass"][i], s["mass_per_mole"]["values"][0], abs_tol=1e-9)
+            assert values["charge"][i] == s["formula_charge"]["values"][0]
+            assert values["mass_per_mole"][i] == s["mass_per_mole"]["values"][0]
+        assert values["mass_discrepancies"] == []
+        assert values["charge_discrepancies"] == []
+
+    def test_molar_mass_charge_discrepancies(self):
+        substances = THERMODATASET["substances"] + [substance("Wrong", "CaCO3", 100.0, 1),
+                                                    substance("Broken", "Ca(OH", 74.092, 0),
+                                                    substance("Quartz", "SiO2", 60.084, 0)]
+        values = self.dbc.getMolarMassCharge(self.load(dict(THERMODATASET, substances=substances)))
+        assert values["mass_discrepancies"] == ["Wrong", "Broken", "Quartz"]
+        assert values["charge_discrepancies"] == ["Wrong", "Broken"]
+        # a formula that is not parsed has no mass nor charge, an element without atomic mass gives no mass
+        assert math.isnan(values["molar_mass"][values["substance_index"]["Broken"]])
+        assert math.isnan(values["charge"][values["substance_index"]["Broken"]])
+        assert math.isnan(values["molar_mass"][values["substance_index"]["Quartz"]])
+        assert values["charge"][values["substance_index"]["Quartz"]] == 0
@@ -0,0 +1,165 @@
+import json
+import os
+import sys
+import tempfile
+import threading
+import time
+import unittest
+
+import pytest as pytest
+import thermohubclient as client
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools"))
+from standin_server import StandInServer  # noqa: E402
+
+
+def thermodataset():
+    elements = [{"symbol": symbol} for symbol in ["C", "Ca", "H", "O"]]
+    substances = [
+        {"symbol": "Ca+2", "formula": "Ca+2", "class_": {"2": "SC_AQSOLUTE"}, "aggregate_state": {"4": "AS_AQUEOUS"}},
+        {"symbol": "CO2@", "formula": "CO2@", "class_": {"2": "SC_AQSOLUTE"}, "aggregate_state": {"4": "AS_AQUEOUS"}},
+        {"symbol": "H2O@", "formula": "H2O@", "class_": {"3": "SC_AQSOLVENT"}, "aggregate_state": {"4": "AS_AQUEOUS"}},
+        {"symbol": "OH-", "formula": "OH-", "class_": {"2": "SC_AQSOLUTE"}, "aggregate_state": {"4": "AS_AQUEOUS"}},
+    ]
+    return {"elements": elements, "substances": substances, "reactions": []}
+
+
+class TestRequestOptions(unittest.TestCase):
+    """Deadlines, retries and hedging of the queries, against a stand-in server answering with injected faults"""
+
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.server = StandInServer({"aq17": thermodataset()}).start()
+        self.config = self.server.writeConfig(os.path.join(self.directory.name, "connection-config.json"))
+
+    def tearDown(self):
+        self.server.stop()
+        self.directory.cleanup()
+
+    def databaseClient(self, **requestOptions):
+        dbc = client.DatabaseClient(self.config)
+        options = client.DatabaseClientOptions()
+        for name, value in requestOptions.items():
+            setattr(options.requestOptions, name, value)
+        dbc.setOptions(options)
+        return dbc
+
+    def symbols(self, jsondata):
+        return [record["symbol"] for record in json.loads(jsondata)["substances"]]
+
+    def test_retry_transient_errors(self):
+        # service unavailable, and the queue full error number of the server
+        self.server.inject(code=503)
+        self.server.inject(code=500, errorNum=21)
+        dbc = self.databaseClient(maxRetries=2, backoffMilliseconds=10)
+        assert self.symbols(dbc.getDatabase("aq17")) == ["CO2@", "Ca+2", "H2O@", "OH-"]
+        assert self.server.queries == 3
+
+    def test_retry_velocypack_transport(self):
+        self.server.inject(code=503)
+        self.server.inject(drop=True)
+        dbc = client.DatabaseClient(self.config)
+        options = client.DatabaseClientOptions()
+        options.velocypackTransport = True
+        options.requestOptions.maxRetries = 2
+        options.requestOptions.backoffMilliseconds = 10
+        dbc.setOptions(options)
+        assert self.symbols(dbc.getDatabase("aq17")) == ["CO2@", "Ca+2", "H2O@", "OH-"]
+        assert self.server.queries == 3
+        assert all("application/x-velocypack" in accept for accept in self.server.accepted)
+        self.server.inject(code=400, errorNum=1501)
+        with pytest.raises(RuntimeError) as error:
+            dbc.getDatabase("aq17")
+        assert not isinstance(error.value, client.TransientError)
+
+    def test_retries_exhausted(self):
+        for _ in range(3):
+            self.server.inject(code=429)
+        dbc = self.databaseClient(maxRetries=1, backoffMilliseconds=10)
+        with pytest.raises(client.TransientError):
+            dbc.getDatabase("aq17")
+        assert self.server.queries == 2
+
+    def test_no_retry_of_query_errors(self):
+        # a query the server cannot parse fails again, it is not retried
+        self.server.inject(code=400, errorNum=1501)
+        dbc = self.databaseClient(maxRetries=3, backoffMilliseconds=10)
+        with pytest.raises(RuntimeError) as error:
+            dbc.getDatabase("aq17")
+        assert not isinstance(error.value, client.TransientError)
+        assert self.server.queries == 1
+
+    def test_retry_dropped_connection(self):
+        # the connection closed without an answer is a TransientError
+        self.server.inject(drop=True)
+        dbc = self.databaseClient(maxRetries=1, backoffMilliseconds=10)
+        assert self.symbols(dbc.getDatabase("aq17")) == ["CO2@", "Ca+2", "H2O@", "OH-"]
+        assert self.server.queries == 2
+        self.server.inject(drop=True)
+        with pytest.raises(client.TransientError):
+            self.databaseClient().getDatabase("aq17")
+
+    def test_attempt_deadline(self):
+        self.server.inject(delay=2.0)
+        dbc = self.databaseClient(timeoutMilliseconds=200)
+        start = time.monotonic()
+        with pytest.raises(client.TimeoutError):
+            dbc.getDatabase("aq17")
+        assert time.monotonic() - start < 1.5
+
+    def test_attempt_deadline_retried(self):
+        # the attempt timed out is retried, the next one answers in time
+        self.server.inject(delay=2.0)
+        dbc = self.databaseClient(timeoutMilliseconds=300, maxRetries=1, backoffMilliseconds=10)
+        assert self.symbols(dbc.getDatabase("aq17")) == ["CO2@", "Ca+2", "H2O@", "OH-"]
+        assert self.server.queries == 2
+
+    def test_total_deadline(self):
+        # the retries and backoff delays stop at the total deadline
+        for _ in range(50):
+            self.server.inject(delay=0.05, code=503)
+        dbc = self.databaseClient(totalTimeoutMilliseconds=500, maxRetries=50, backoffMilliseconds=20, maxBackoffMilliseconds=100)
+        start = time.monotonic()
+        with pytest.raises(client.TimeoutError):
+            dbc.getDatabase("aq17")
+        assert time.monotonic() - start < 2.0
+        assert 1 < self.server.queries < 50
+
+    def test_hedged_query(self):
+        # the first query stalls, the duplicate sent after hedgeAfterMilliseconds answers first
+        self.server.inject(delay=3.0)
+        dbc = self.databaseClient(hedgeAfterMilliseconds=100)
+        start = time.monotonic()
+        assert self.symbols(dbc.getDatabase("aq17")) == ["CO2@", "Ca+2", "H2O@", "OH-"]
+        assert time.monotonic() - start < 2.0
+        assert self.server.queries == 2
+
+    def test_cancelled_leader_of_coalesced_queries(self):
+        # a query waiting for the identical query of a cancelled request is sent again
+        self.server.inject(delay=2.0)
+        leader = self.databaseClient()
+        token = client.CancellationToken()
+        leader.setCancellationToken(token)
+        follower = self.databaseClient()
+        errors = []
+        results = []
+
+        def request(dbc, output):
+            try:
+                output.append(dbc.getDatabase("aq17"))
+            except Exception as e:
+                errors.append(e)
+
+        leading = threading.Thread(target=request, args=(leader, []))
+        following = threading.Thread(target=request, args=(follower, results))
+        leading.start()
+        while self.server.queries == 0:
+            time.sleep(0.01)
+        following.start()
+        time.sleep(0.2)
+        token.cancel()
+        leading.join()
+        following.join()
+        assert [type(e) for e in errors] == [client.CancelledError]
+        assert len(results) == 1 and self.symbols(results[0]) == ["CO2@", "Ca+2", "H2O@", "OH-"]
+        assert self.server.queries == 2
@@ -20,5 +20,9 @@ using namespace ThermoHubClient;
 PYBIND11_MODULE(PyThermoHubClient, m)
 {
     // Database Client
+    exportDatabaseClientOptions(m);
     exportDatabaseClient(m);
+
+    // Cache Daemon
+    exportCacheDaemon(m);
 }
\ No newline at end of file
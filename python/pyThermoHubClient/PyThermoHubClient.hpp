@@ -20,4 +20,8 @@ namespace py = pybind11;
 namespace ThermoHubClient {
     // Database Client
     void exportDatabaseClient(py::module& m);
+    void exportDatabaseClientOptions(py::module& m);
+
+    // Cache Daemon
+    void exportCacheDaemon(py::module& m);
 } // namespace ThermoHubClient
@@ -0,0 +1,46 @@
+// Copyright (C) 2020 G. D. Miron, D. A. Kulik, S. V Dmytrieva
+// 
+// thermohubclient is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// thermohubclient is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with thermohubclient. If not, see <http://www.gnu.org/licenses/>.
+
+
+// pybind11 includes
+#include <pybind11/pybind11.h>
+namespace py = pybind11;
+
+// ThermoHubClient includes
+#include <ThermoHubClient/CacheDaemon.h>
+
+namespace ThermoHubClient {
+
+void exportCacheDaemon(py::module& m)
+{
+    py::class_<CacheDaemonOptions>(m, "CacheDaemonOptions")
+        .def(py::init<>())
+        .def_readwrite("workers", &CacheDaemonOptions::workers, "threads serving the connections, 0 for the hardware threads (at least 2)")
+        .def_readwrite("timeToLiveSeconds", &CacheDaemonOptions::timeToLiveSeconds, "seconds a downloaded ThermoDataSet is served before it is downloaded again, 0 to keep it")
+        .def_readwrite("connectionTimeoutSeconds", &CacheDaemonOptions::connectionTimeoutSeconds, "seconds a connection may wait for a client to send its request or take its answer")
+        ;
+
+    // run releases the GIL, so that another Python thread can stop the daemon
+    py::class_<CacheDaemon>(m, "CacheDaemon")
+        .def(py::init<const std::string&>())
+        .def(py::init<const std::string&, const std::string&>())
+        .def(py::init<const std::string&, const std::string&, const CacheDaemonOptions&>())
+        .def("run", &CacheDaemon::run, py::call_guard<py::gil_scoped_release>(), "Serve requests until stop() is called")
+        .def("stop", &CacheDaemon::stop, "Make run() return")
+        .def("reload", &CacheDaemon::reload, "Drop the ThermoDataSets held, the next requests download them again")
+        ;
+}
+
+} // namespace ThermoHubClient
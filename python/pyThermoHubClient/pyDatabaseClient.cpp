@@ -16,47 +16,366 @@
 // pybind11 includes
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 namespace py = pybind11;
 
 // ThermoFun includes
 #include <ThermoHubClient/DatabaseClient.h>
+#include <ThermoHubClient/ThermoDataSetDiff.h>
 
 namespace ThermoHubClient {
 
+/// Wrap a row-major vector of values into a 2D numpy array without copying the data
+auto toArray(std::vector<double>&& values, std::size_t rows, std::size_t cols) -> py::array_t<double>
+{
+    // the capsule owns the vector once it is created, before that the unique_ptr does
+    std::unique_ptr<std::vector<double>> data(new std::vector<double>(std::move(values)));
+    auto buffer = data->data();
+    py::capsule owner(data.get(), [](void* p) { delete reinterpret_cast<std::vector<double>*>(p); });
+    data.release();
+    return py::array_t<double>({rows, cols}, {cols * sizeof(double), sizeof(double)}, buffer, owner);
+}
+
+/// Map each symbol to its row index in the columns
+auto toIndex(const std::vector<std::string>& symbols) -> py::dict
+{
+    py::dict index;
+    for (std::size_t i = 0; i < symbols.size(); ++i)
+        index[py::str(symbols[i])] = i;
+    return index;
+}
+
+/// Wrap a vector into a 1D numpy array without copying the data
+template <typename T>
+auto toArray(std::vector<T>&& values) -> py::array_t<T>
+{
+    std::unique_ptr<std::vector<T>> data(new std::vector<T>(std::move(values)));
+    auto size = data->size();
+    auto buffer = data->data();
+    py::capsule owner(data.get(), [](void* p) { delete reinterpret_cast<std::vector<T>*>(p); });
+    data.release();
+    return py::array_t<T>(size, buffer, owner);
+}
+
+/// A sparse matrix as a dense numpy array, or as the data, indices and indptr of scipy.sparse.csr_matrix
+template <typename Matrix>
+auto addMatrix(py::dict& result, Matrix&& matrix, bool dense) -> void
+{
+    const auto rows = matrix.rows();
+    const auto cols = matrix.cols();
+    result["shape"] = py::make_tuple(rows, cols);
+    if (dense)
+        result["matrix"] = toArray(matrix.dense(), rows, cols);
+    else
+    {
+        result["data"] = toArray(std::move(matrix.values));
+        result["indices"] = toArray(std::move(matrix.columns));
+        result["indptr"] = toArray(std::move(matrix.rowOffsets));
+    }
+}
+
+auto formulaMatrixToDict(FormulaMatrix&& matrix, bool dense) -> py::dict
+{
+    py::dict result;
+    result["elements"] = matrix.elements;
+    result["element_index"] = toIndex(matrix.elements);
+    result["substances"] = matrix.substances;
+    result["substance_index"] = toIndex(matrix.substances);
+    std::vector<std::string> failed;
+    for (auto j : matrix.failedColumns)
+        failed.push_back(matrix.substances[j]);
+    result["failed_substances"] = failed;
+    result["failures"] = matrix.failures;
+    addMatrix(result, std::move(matrix), dense);
+    return result;
+}
+
+auto reactionMatrixToDict(ReactionMatrix&& matrix, bool dense) -> py::dict
+{
+    py::dict result;
+    result["reactions"] = matrix.reactions;
+    result["reaction_index"] = toIndex(matrix.reactions);
+    result["substances"] = matrix.substances;
+    result["substance_index"] = toIndex(matrix.substances);
+    result["unknown_reactants"] = matrix.unknownReactants;
+    addMatrix(result, std::move(matrix), dense);
+    return result;
+}
+
+auto reactionBalanceToDict(ReactionBalance&& balance) -> py::dict
+{
+    py::dict result;
+    const auto nreactions = balance.reactions.size();
+    result["reactions"] = balance.reactions;
+    result["elements"] = balance.elements;
+    result["residuals"] = toArray(std::move(balance.residuals), nreactions, balance.elements.size());
+    std::vector<std::string> unbalanced;
+    for (auto i : balance.unbalanced)
+        unbalanced.push_back(balance.reactions[i]);
+    result["unbalanced"] = unbalanced;
+    return result;
+}
+
+auto molarMassChargeToDict(MolarMassCharge&& values) -> py::dict
+{
+    auto symbols = [&values](const std::vector<std::size_t>& positions) {
+        std::vector<std::string> selected;
+        for (auto i : positions)
+            selected.push_back(values.substances[i]);
+        return selected;
+    };
+    py::dict result;
+    result["substances"] = values.substances;
+    result["substance_index"] = toIndex(values.substances);
+    result["mass_discrepancies"] = symbols(values.massDiscrepancies);
+    result["charge_discrepancies"] = symbols(values.chargeDiscrepancies);
+    result["molar_mass"] = toArray(std::move(values.molarMasses));
+    result["charge"] = toArray(std::move(values.charges));
+    result["mass_per_mole"] = toArray(std::move(values.storedMolarMasses));
+    result["formula_charge"] = toArray(std::move(values.storedCharges));
+    return result;
+}
+
+auto diffToDict(const ThermoDataSetDiff& diff) -> py::dict
+{
+    auto changesToDict = [](const RecordChanges& changes) {
+        py::dict result;
+        result["added"] = changes.added;
+        result["removed"] = changes.removed;
+        result["modified"] = changes.modified;
+        result["duplicated"] = changes.duplicated;
+        return result;
+    };
+    py::dict result;
+    result["elements"] = changesToDict(diff.elements);
+    result["substances"] = changesToDict(diff.substances);
+    result["reactions"] = changesToDict(diff.reactions);
+    return result;
+}
+
+auto columnsToDict(ThermoDataColumns&& columns) -> py::dict
+{
+    py::dict result;
+    const auto nsubstances = columns.substanceSymbols.size();
+    const auto nreactions = columns.reactionSymbols.size();
+    result["substance_properties"] = columns.substanceProperties;
+    result["substance_symbols"] = columns.substanceSymbols;
+    result["substance_index"] = toIndex(columns.substanceSymbols);
+    result["substances"] = toArray(std::move(columns.substanceValues), nsubstances, columns.substanceProperties.size());
+    result["reaction_properties"] = columns.reactionProperties;
+    result["reaction_symbols"] = columns.reactionSymbols;
+    result["reaction_index"] = toIndex(columns.reactionSymbols);
+    result["reactions"] = toArray(std::move(columns.reactionValues), nreactions, columns.reactionProperties.size());
+    return result;
+}
+
 void exportDatabaseClient(py::module& m)
 {
+    py::class_<DatabaseResult>(m, "DatabaseResult", py::buffer_protocol())
+        .def("__str__", &DatabaseResult::str)
+        .def("__len__", &DatabaseResult::size)
+        .def_buffer([](const DatabaseResult& self) {
+            // read-only bytes view of the shared JSON string, e.g. file.write(result) or bytes(result)
+            return py::buffer_info(const_cast<char*>(self.data()), sizeof(char), py::format_descriptor<char>::format(),
+                                   1, {self.size()}, {sizeof(char)}, true);
+        })
+        ;
+
+    py::class_<RequestMemoryStats>(m, "RequestMemoryStats")
+        .def_readonly("peakResidentBytes", &RequestMemoryStats::peakResidentBytes, "peak resident memory of the process after the request, in bytes")
+        .def_readonly("peakIncreaseBytes", &RequestMemoryStats::peakIncreaseBytes, "increase of the peak resident memory of the whole process during the request, in bytes (not the memory of this request alone, 0 below an earlier peak)")
+        ;
+
+    py::register_exception<CancelledError>(m, "CancelledError", PyExc_RuntimeError);
+
+    py::class_<CancellationToken>(m, "CancellationToken")
+        .def(py::init<>())
+        .def("cancel", &CancellationToken::cancel, "Cancel the requests of the clients the token is set on")
+        .def("isCancelled", &CancellationToken::isCancelled)
+        ;
+
+    py::enum_<RequestStage>(m, "RequestStage")
+        .value("Fetch", RequestStage::Fetch)
+        .value("Parse", RequestStage::Parse)
+        .value("Filter", RequestStage::Filter)
+        .value("Write", RequestStage::Write)
+        ;
+
+    py::class_<RequestProgress>(m, "RequestProgress")
+        .def_readonly("stage", &RequestProgress::stage)
+        .def_readonly("bytesReceived", &RequestProgress::bytesReceived, "size of the query result received, in bytes")
+        .def_readonly("recordsProcessed", &RequestProgress::recordsProcessed, "records (elements, substances, reactions) parsed")
+        .def_readonly("bytesWritten", &RequestProgress::bytesWritten, "bytes written to the database file (before compression)")
+        ;
+
+    // the get and save functions release the GIL, so that other threads can cancel them
     py::class_<DatabaseClient>(m, "DatabaseClient")
         .def(py::init<>())
         .def(py::init<const std::string&>())
-        .def("getDatabase", (const std::string& (DatabaseClient::*)(const std::string&) const) &DatabaseClient::getDatabase,
+        .def(py::init<const std::string&, const DatabaseClientOptions&>())
+        .def("getDatabase", [](const DatabaseClient& self, const std::string& thermodataset) { return self.getDatabase(thermodataset).str(); }, py::call_guard<py::gil_scoped_release>(),
                   "Get thermodataset database JSON string for a given ThermoDataSet symbol", "thermodataset")
-        .def("getDatabaseContainingElements", &DatabaseClient::getDatabaseContainingElements,
+        .def("getDatabaseContainingElements", [](const DatabaseClient& self, const std::string& thermodataset, const std::vector<std::string>& elements) {
+                      return self.getDatabaseContainingElements(thermodataset, elements).str();
+                  }, py::call_guard<py::gil_scoped_release>(),
                   "Get thermodataset database JSON string for a given ThermoDataSet symbol and a list of elements", "thermodataset", "elements")
-        .def("getDatabaseSubset", &DatabaseClient::getDatabaseSubset,
+        .def("getDatabaseSubset", [](const DatabaseClient& self, const std::string& thermodataset, const std::vector<std::string>& elements,
+                                     const std::vector<std::string>& substances, const std::vector<std::string>& classesOfSubstance,
+                                     const std::vector<std::string>& aggregateStates) {
+                      return self.getDatabaseSubset(thermodataset, elements, substances, classesOfSubstance, aggregateStates).str();
+                  }, py::call_guard<py::gil_scoped_release>(),
                   "Get thermodataset database JSON string for a given ThermoDataSet symbol and optional a list of elements, substances, substance classes, substance aggregate states",
                   py::arg("thermodataset"), py::arg("elements") = std::vector<std::string>(), py::arg("substances") = std::vector<std::string>(), 
                   py::arg("classesOfSubstance") = std::vector<std::string>(), py::arg("aggregateStates") = std::vector<std::string>())
-        .def("saveDatabase", (void (DatabaseClient::*)(const std::string&)) &DatabaseClient::saveDatabase,
+        .def("getDatabaseResult", &DatabaseClient::getDatabaseSubset, py::call_guard<py::gil_scoped_release>(),
+                  "As getDatabaseSubset, but returns the shared JSON string as a DatabaseResult (bytes buffer) without copying it into a Python str",
+                  py::arg("thermodataset"), py::arg("elements") = std::vector<std::string>(), py::arg("substances") = std::vector<std::string>(), 
+                  py::arg("classesOfSubstance") = std::vector<std::string>(), py::arg("aggregateStates") = std::vector<std::string>())
+        .def("getDatabaseColumns", [](const DatabaseClient& self, const std::string& thermodataset, const std::vector<std::string>& elements,
+                                      const std::vector<std::string>& substances, const std::vector<std::string>& classesOfSubstance,
+                                      const std::vector<std::string>& aggregateStates) {
+                      ThermoDataColumns columns;
+                      {
+                          py::gil_scoped_release release;
+                          columns = self.getDatabaseColumns(thermodataset, elements, substances, classesOfSubstance, aggregateStates);
+                      }
+                      return columnsToDict(std::move(columns));
+                  },
+                  "Get the thermodynamic properties of substances (sm_*) and reactions (logKr) as numpy arrays, one row per record, for a given ThermoDataSet symbol and optional a list of elements, substances, substance classes, substance aggregate states",
+                  py::arg("thermodataset"), py::arg("elements") = std::vector<std::string>(), py::arg("substances") = std::vector<std::string>(), 
+                  py::arg("classesOfSubstance") = std::vector<std::string>(), py::arg("aggregateStates") = std::vector<std::string>())
+        .def("getFormulaMatrix", [](const DatabaseClient& self, const std::string& thermodataset, const std::vector<std::string>& elements,
+                                    bool chargeRow, bool dense) {
+                      FormulaMatrix matrix;
+                      {
+                          py::gil_scoped_release release;
+                          matrix = self.getFormulaMatrix(thermodataset, elements, chargeRow);
+                      }
+                      return formulaMatrixToDict(std::move(matrix), dense);
+                  },
+                  "Get the formula matrix (elements x substances) of a given ThermoDataSet symbol and optional a list of elements, as a numpy array "
+                  "or (dense=False) as the data, indices and indptr of a scipy.sparse.csr_matrix, with the substances whose formula failed (empty columns) and the reasons",
+                  py::arg("thermodataset"), py::arg("elements") = std::vector<std::string>(), py::arg("chargeRow") = true, py::arg("dense") = true)
+        .def("getReactionMatrix", [](const DatabaseClient& self, const std::string& thermodataset, const std::vector<std::string>& elements, bool dense) {
+                      ReactionMatrix matrix;
+                      {
+                          py::gil_scoped_release release;
+                          matrix = self.getReactionMatrix(thermodataset, elements);
+                      }
+                      return reactionMatrixToDict(std::move(matrix), dense);
+                  },
+                  "Get the reactant coefficients (reactions x substances) of a given ThermoDataSet symbol and optional a list of elements, as a numpy array "
+                  "or (dense=False) as the data, indices and indptr of a scipy.sparse.csr_matrix",
+                  py::arg("thermodataset"), py::arg("elements") = std::vector<std::string>(), py::arg("dense") = true)
+        .def("checkReactionBalance", [](const DatabaseClient& self, const std::string& thermodataset, const std::vector<std::string>& elements, double tolerance) {
+                      ReactionBalance balance;
+                      {
+                          py::gil_scoped_release release;
+                          balance = self.checkReactionBalance(thermodataset, elements, tolerance);
+                      }
+                      return reactionBalanceToDict(std::move(balance));
+                  },
+                  "Check the element and charge balance of all reactions of a given ThermoDataSet symbol and optional a list of elements: "
+                  "the residuals (reactions x elements) as numpy array and the symbols of the unbalanced reactions",
+                  py::arg("thermodataset"), py::arg("elements") = std::vector<std::string>(), py::arg("tolerance") = 1e-6)
+        .def("getMolarMassCharge", [](const DatabaseClient& self, const std::string& thermodataset, const std::vector<std::string>& elements, double tolerance) {
+                      MolarMassCharge values;
+                      {
+                          py::gil_scoped_release release;
+                          values = self.getMolarMassCharge(thermodataset, elements, tolerance);
+                      }
+                      return molarMassChargeToDict(std::move(values));
+                  },
+                  "Compute the molar mass and charge of all substances of a given ThermoDataSet symbol and optional a list of elements from their formulas, "
+                  "as numpy arrays next to the stored mass_per_mole and formula_charge, with the symbols of the substances whose stored values differ",
+                  py::arg("thermodataset"), py::arg("elements") = std::vector<std::string>(), py::arg("tolerance") = 1e-4)
+        .def("saveDatabase", (void (DatabaseClient::*)(const std::string&)) &DatabaseClient::saveDatabase, py::call_guard<py::gil_scoped_release>(),
                   "Save thermodataset database to JSON file, for a given ThermoDataSet symbol", "thermodataset")
-        .def("saveDatabaseContainingElements", &DatabaseClient::saveDatabaseContainingElements,
+        .def("saveDatabaseContainingElements", &DatabaseClient::saveDatabaseContainingElements, py::call_guard<py::gil_scoped_release>(),
                   "Save thermodataset database to JSON file, for a given ThermoDataSet symbol and a list of elements", "thermodataset", "elements")
-        .def("saveDatabaseSubset", &DatabaseClient::saveDatabaseSubset,
+        .def("saveDatabaseSubset", &DatabaseClient::saveDatabaseSubset, py::call_guard<py::gil_scoped_release>(),
                   "Save subset thermodataset database to a JSON file for a given ThermoDataSet symbol and optional a list of elements, substances, substance classes, substance aggregate states",
                   py::arg("thermodataset"), py::arg("elements") = std::vector<std::string>(), py::arg("substances") = std::vector<std::string>(), 
                   py::arg("classesOfSubstance") = std::vector<std::string>(), py::arg("aggregateStates") = std::vector<std::string>())
-        .def("availableThermoDataSets", &DatabaseClient::availableThermoDataSets,"list of available ThermoDataSets", "thermodataset")
-        .def("substanceClassesInThermoDataSet", &DatabaseClient::substanceClassesInThermoDataSet,"list of substance classes in a ThermoDataSet", "thermodataset")
-        .def("substanceAggregateStatesInThermoDataSet", &DatabaseClient::substanceAggregateStatesInThermoDataSet,"list of substance aggregate states in ThermoDataSet", "thermodataset")
-        .def("elementsInThermoDataSet", &DatabaseClient::elementsInThermoDataSet,"list of elements in a ThermoDataSet", "thermodataset")
-        .def("substancesInThermoDataSet", &DatabaseClient::substancesInThermoDataSet,"list of substances in a ThermoDataSet", "thermodataset")
-        .def("reactionsInThermoDataSet", &DatabaseClient::reactionsInThermoDataSet,"list of reactions in a ThermoDataSet", "thermodataset")        
-        .def("setOptions", &DatabaseClient::setOptions, "set options: json_indent_save, json_indent_get, filterCharge, databaseFileSuffix, subsetFileSuffix")
+        .def("availableThermoDataSets", &DatabaseClient::availableThermoDataSets, py::call_guard<py::gil_scoped_release>(), "list of available ThermoDataSets", "thermodataset")
+        .def("substanceClassesInThermoDataSet", &DatabaseClient::substanceClassesInThermoDataSet, py::call_guard<py::gil_scoped_release>(), "list of substance classes in a ThermoDataSet", "thermodataset")
+        .def("substanceAggregateStatesInThermoDataSet", &DatabaseClient::substanceAggregateStatesInThermoDataSet, py::call_guard<py::gil_scoped_release>(), "list of substance aggregate states in ThermoDataSet", "thermodataset")
+        .def("elementsInThermoDataSet", &DatabaseClient::elementsInThermoDataSet, py::call_guard<py::gil_scoped_release>(), "list of elements in a ThermoDataSet", "thermodataset")
+        .def("substancesInThermoDataSet", &DatabaseClient::substancesInThermoDataSet, py::call_guard<py::gil_scoped_release>(), "list of substances in a ThermoDataSet", "thermodataset")
+        .def("reactionsInThermoDataSet", &DatabaseClient::reactionsInThermoDataSet, py::call_guard<py::gil_scoped_release>(), "list of reactions in a ThermoDataSet", "thermodataset")        
+        .def("loadThermoDataSet", &DatabaseClient::loadThermoDataSet, py::call_guard<py::gil_scoped_release>(),
+                  "Load a complete ThermoDataSet from a (compressed) database file, following requests for it are answered locally", py::arg("thermodataset"), py::arg("fileName"))
+        .def("clearCachedThermoDataSets", &DatabaseClient::clearCachedThermoDataSets, py::call_guard<py::gil_scoped_release>(), "Remove the ThermoDataSets held in memory (loaded or cached)")
+        .def("lastRequestMemory", &DatabaseClient::lastRequestMemory, py::call_guard<py::gil_scoped_release>(), "Peak resident memory of the process around the last get, save or columns request")
+        .def("isReady", &DatabaseClient::isReady, "True when the background prefetch of the ThermoDataSets in prefetchThermoDataSets is finished")
+        .def("waitUntilReady", &DatabaseClient::waitUntilReady, py::call_guard<py::gil_scoped_release>(),
+             "Wait for the background prefetch, False if the timeout expired", py::arg("timeoutMilliseconds") = -1)
+        .def("setCancellationToken", &DatabaseClient::setCancellationToken, py::call_guard<py::gil_scoped_release>(),
+             "Cancel the following get, save and columns requests with a CancelledError when the token is cancelled", py::arg("token"))
+        .def("setProgressCallback", &DatabaseClient::setProgressCallback, py::call_guard<py::gil_scoped_release>(),
+             "Call callback(RequestProgress) at each stage of the following get, save and columns requests, and periodically while parsing and writing", py::arg("callback"))
+        .def("setOptions", &DatabaseClient::setOptions, py::call_guard<py::gil_scoped_release>(), "set options: json_indent_save, json_indent_get, filterCharge, databaseFileSuffix, subsetFileSuffix, fileCompression, cacheThermoDataSets, cacheMaxThermoDataSets, cacheTimeToLiveSeconds, prefetchThermoDataSets, selectedProperties, aqlOptions, cacheDaemonSocket, requestOptions, numThreads, velocypackTransport")
         ;
 
 }
 
 void exportDatabaseClientOptions(py::module& m)
 {
+    py::enum_<FileCompression>(m, "FileCompression")
+        .value("Plain", FileCompression::Plain)
+        .value("Gzip", FileCompression::Gzip)
+        .value("Zstd", FileCompression::Zstd)
+        ;
+
+    m.def("readDatabaseFile", &readDatabaseFile, "Read a database JSON string from a .json, .json.gz or .json.zst file", py::arg("fileName"));
+    m.def("writeDatabaseFile", &writeDatabaseFile, "Write a database JSON string to a .json, .json.gz or .json.zst file", py::arg("fileName"), py::arg("jsondata"));
+
+    py::class_<ThermoDataSetHashes>(m, "ThermoDataSetHashes")
+        .def("__len__", [](const ThermoDataSetHashes& self) { return self.elements.size() + self.substances.size() + self.reactions.size(); })
+        ;
+
+    m.def("hashDatabaseFile", &hashDatabaseFile, py::call_guard<py::gil_scoped_release>(),
+          "Hash the records of a .json, .json.gz or .json.zst database file by symbol and content, parsing one record at a time", py::arg("fileName"));
+    m.def("hashThermoDataSetText", [](const DatabaseResult& result) { return hashThermoDataSetText(result.str()); }, py::call_guard<py::gil_scoped_release>(),
+          "Hash the records of a database JSON result by symbol and content", py::arg("jsondata"));
+    m.def("hashThermoDataSetText", &hashThermoDataSetText, py::call_guard<py::gil_scoped_release>(),
+          "Hash the records of a database JSON string by symbol and content", py::arg("jsondata"));
+    m.def("diffThermoDataSets", [](const ThermoDataSetHashes& before, const ThermoDataSetHashes& after) { return diffToDict(diffThermoDataSets(before, after)); },
+          "Symbols of the elements, substances and reactions added, removed and modified between two hashed ThermoDataSets, with the duplicated symbols", py::arg("before"), py::arg("after"));
+    m.def("diffDatabaseFiles", [](const std::string& before, const std::string& after) {
+              ThermoDataSetDiff diff;
+              {
+                  py::gil_scoped_release release;
+                  diff = diffDatabaseFiles(before, after);
+              }
+              return diffToDict(diff);
+          },
+          "Symbols of the elements, substances and reactions added, removed and modified between two database files, read one record at a time, with the duplicated symbols",
+          py::arg("before"), py::arg("after"));
+
+    py::class_<AqlQueryOptions>(m, "AqlQueryOptions")
+        .def(py::init<>())
+        .def_readwrite("maxPlans", &AqlQueryOptions::maxPlans, "maximum number of execution plans considered by the optimizer (0 for the server default)")
+        .def_readwrite("optimizerRules", &AqlQueryOptions::optimizerRules, "optimizer rules, '-all' disables all rules, '+name' enables and '-name' disables a rule")
+        .def_readwrite("stream", &AqlQueryOptions::stream, "stream the results instead of computing them completely first")
+        .def_readwrite("maxRuntime", &AqlQueryOptions::maxRuntime, "abort queries running longer than this number of seconds (0 for no limit)")
+        ;
+
+    py::class_<RequestOptions>(m, "RequestOptions")
+        .def(py::init<>())
+        .def_readwrite("timeoutMilliseconds", &RequestOptions::timeoutMilliseconds, "deadline of one query attempt in milliseconds, TimeoutError when exceeded (0 for no deadline)")
+        .def_readwrite("totalTimeoutMilliseconds", &RequestOptions::totalTimeoutMilliseconds, "deadline of a query with all its attempts and backoff delays in milliseconds, TimeoutError when exceeded (0 for no deadline)")
+        .def_readwrite("maxRetries", &RequestOptions::maxRetries, "retries of a query after a TransientError (connection failure, server overload, timeout)")
+        .def_readwrite("backoffMilliseconds", &RequestOptions::backoffMilliseconds, "delay before the first retry in milliseconds, doubled for each further retry (with random jitter)")
+        .def_readwrite("maxBackoffMilliseconds", &RequestOptions::maxBackoffMilliseconds, "upper limit of the delay between retries in milliseconds")
+        .def_readwrite("hedgeAfterMilliseconds", &RequestOptions::hedgeAfterMilliseconds, "send a duplicate query when no result arrived after this many milliseconds, the first result is used (0 for no hedging)")
+        .def_readwrite("maxAttemptsInFlight", &RequestOptions::maxAttemptsInFlight, "attempts of a client running at a time in their own threads (0 for no limit), attempts left behind by timeouts keep their place until the server answers")
+        ;
+
+    auto transientError = py::register_exception<TransientError>(m, "TransientError", PyExc_RuntimeError);
+    py::register_exception<TimeoutError>(m, "TimeoutError", transientError.ptr());
+
     py::class_<DatabaseClientOptions>(m, "DatabaseClientOptions")
         .def(py::init<>())
         .def_readwrite("json_indent_save", &DatabaseClientOptions::json_indent_save, "number of spaces in the json indentation (in the saved json file)")
@@ -64,6 +383,17 @@ void exportDatabaseClientOptions(py::module& m)
         .def_readwrite("filterCharge", &DatabaseClientOptions::filterCharge, "filter charge when selecting data by elements")
         .def_readwrite("databaseFileSuffix", &DatabaseClientOptions::databaseFileSuffix, "database filename suffix")
         .def_readwrite("subsetFileSuffix", &DatabaseClientOptions::subsetFileSuffix, "subset database filename suffix")
+        .def_readwrite("fileCompression", &DatabaseClientOptions::fileCompression, "compression of the saved database files (adds .gz or .zst to the file name)")
+        .def_readwrite("cacheThermoDataSets", &DatabaseClientOptions::cacheThermoDataSets, "keep complete ThermoDataSets in memory and select subsets locally")
+        .def_readwrite("cacheMaxThermoDataSets", &DatabaseClientOptions::cacheMaxThermoDataSets, "complete ThermoDataSets downloaded and kept in memory at most, the least recently used one is dropped first (0 for no limit)")
+        .def_readwrite("cacheTimeToLiveSeconds", &DatabaseClientOptions::cacheTimeToLiveSeconds, "seconds after which a downloaded ThermoDataSet is downloaded again by the next request for it (0 for never)")
+        .def_readwrite("prefetchThermoDataSets", &DatabaseClientOptions::prefetchThermoDataSets, "ThermoDataSets fetched and kept in memory by a background thread when the options are set")
+        .def_readwrite("selectedProperties", &DatabaseClientOptions::selectedProperties, "properties of the substances and reactions to download (all if empty), the symbol is always included")
+        .def_readwrite("aqlOptions", &DatabaseClientOptions::aqlOptions, "execution options of the ThermoDataSet queries")
+        .def_readwrite("cacheDaemonSocket", &DatabaseClientOptions::cacheDaemonSocket, "Unix domain socket of a cache daemon serving the ThermoDataSets to all processes of the node")
+        .def_readwrite("requestOptions", &DatabaseClientOptions::requestOptions, "deadlines, retries and hedging of the queries to the server")
+        .def_readwrite("numThreads", &DatabaseClientOptions::numThreads, "threads selecting the substances and reactions by elements (1 selects in the calling thread, 0 uses all hardware threads)")
+        .def_readwrite("velocypackTransport", &DatabaseClientOptions::velocypackTransport, "receive the ThermoDataSet query results as VelocyPack instead of JSON text, decoded without parsing text")
         ;
 }
 }
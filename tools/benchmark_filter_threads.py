@@ -0,0 +1,68 @@
+"""Measure how the selection of substances and reactions by elements scales with DatabaseClientOptions.numThreads.
+
+Only the selection is timed: the subset is saved to a file in a temporary directory, and the time
+from the Filter stage to the Write stage of the request is measured (the download, the parsing and
+the writing of the ThermoDataSet are excluded), against a local ArangoDB holding a copy of the
+ThermoHub data, or tools/standin_server.py serving database files (the server is given by a
+connection configuration file), e.g.
+
+    python tools/standin_server.py aq17.json --config local-hub-config.json &
+
+    python tools/benchmark_filter_threads.py local-hub-config.json aq17 --elements H O C Na Cl --threads 1 2 4 8 16 32 64
+"""
+
+import argparse
+import os
+import statistics
+import tempfile
+import time
+
+import thermohubclient as client
+
+
+def time_filter(dbc, thermodataset, elements, repeat):
+    times = []
+    for _ in range(repeat):
+        stages = {}
+        dbc.setProgressCallback(lambda p: stages.setdefault(p.stage, time.perf_counter()))
+        dbc.saveDatabaseContainingElements(thermodataset, elements)
+        times.append(stages[client.RequestStage.Write] - stages[client.RequestStage.Filter])
+    return statistics.median(times)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("config", help="connection configuration file of the stand-in server")
+    parser.add_argument("thermodatasets", nargs="+", help="symbols of the ThermoDataSets to query")
+    parser.add_argument("--elements", nargs="+", default=["H", "O", "C", "Na", "Cl"], help="elements of the selection")
+    parser.add_argument("--threads", nargs="+", type=int, default=None, help="values of numThreads (powers of two up to the cores by default)")
+    parser.add_argument("--repeat", type=int, default=3, help="requests per setting (the median time is reported)")
+    args = parser.parse_args()
+
+    threads = args.threads
+    if threads is None:
+        threads = [1]
+        while threads[-1] * 2 <= os.cpu_count():
+            threads.append(threads[-1] * 2)
+
+    dbc = client.DatabaseClient(os.path.abspath(args.config))
+    # the saved subsets are written to the working directory
+    directory = tempfile.TemporaryDirectory()
+    os.chdir(directory.name)
+    for thermodataset in args.thermodatasets:
+        print(f"{thermodataset} ({' '.join(args.elements)})")
+        print(f"  {'threads':>7}  {'seconds':>9}  {'speedup':>7}")
+        single = None
+        for num_threads in threads:
+            options = client.DatabaseClientOptions()
+            options.numThreads = num_threads
+            # each request queries the server and selects by elements, a cached subset would be timed instead
+            options.cacheThermoDataSets = False
+            dbc.setOptions(options)
+            seconds = time_filter(dbc, thermodataset, args.elements, args.repeat)
+            single = single or seconds
+            print(f"  {num_threads:7d}  {seconds:9.3f}  {single / seconds:7.2f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,66 @@
+"""Measure the time and the peak memory of getDatabase requests answered by the server.
+
+The peak resident memory is a high-water mark of the whole process, so each request runs in a
+fresh Python process: the increase of the peak during the request is then the memory taken by the
+download, the parsed ThermoDataSet and the result together. It is reported with the size of the
+result, against a local ArangoDB holding a copy of the ThermoHub data, or tools/standin_server.py serving
+database files (the server is given by a connection configuration file), e.g.
+
+    python tools/standin_server.py aq17.json cemdata18.json.gz --config local-hub-config.json &
+
+    python tools/benchmark_request_memory.py local-hub-config.json aq17 cemdata18 --elements H O C Na Cl
+
+Run it before and after a change of the parsing or filtering of the query results to compare them.
+"""
+
+import argparse
+import json
+import statistics
+import subprocess
+import sys
+import time
+
+import thermohubclient as client
+
+
+def request(config, thermodataset, elements):
+    dbc = client.DatabaseClient(config)
+    start = time.perf_counter()
+    result = dbc.getDatabaseContainingElements(thermodataset, elements) if elements else dbc.getDatabase(thermodataset)
+    seconds = time.perf_counter() - start
+    memory = dbc.lastRequestMemory()
+    return {"seconds": seconds, "resultBytes": len(result), "peakIncreaseBytes": memory.peakIncreaseBytes}
+
+
+def measure(config, thermodataset, elements):
+    command = [sys.executable, __file__, config, thermodataset, "--single"]
+    if elements:
+        command += ["--elements"] + elements
+    output = subprocess.run(command, check=True, capture_output=True, text=True).stdout
+    return json.loads(output.splitlines()[-1])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("config", help="connection configuration file of the stand-in server")
+    parser.add_argument("thermodatasets", nargs="+", help="symbols of the ThermoDataSets to query")
+    parser.add_argument("--elements", nargs="*", default=[], help="elements of the selection (the whole ThermoDataSet if none)")
+    parser.add_argument("--repeat", type=int, default=3, help="requests per ThermoDataSet (the median is reported)")
+    parser.add_argument("--single", action="store_true", help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.single:
+        print(json.dumps(request(args.config, args.thermodatasets[0], args.elements)))
+        return
+
+    print(f"  {'thermodataset':<16}  {'seconds':>9}  {'result MB':>9}  {'peak MB':>9}  {'peak/result':>11}")
+    for thermodataset in args.thermodatasets:
+        runs = [measure(args.config, thermodataset, args.elements) for _ in range(args.repeat)]
+        seconds = statistics.median(run["seconds"] for run in runs)
+        result = runs[0]["resultBytes"]
+        peak = statistics.median(run["peakIncreaseBytes"] for run in runs)
+        print(f"  {thermodataset:<16}  {seconds:9.3f}  {result / 2**20:9.1f}  {peak / 2**20:9.1f}  {peak / max(result, 1):11.2f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,57 @@
+"""Compare the ThermoDataSet queries answered as JSON text and as VelocyPack (DatabaseClientOptions.velocypackTransport).
+
+Each request downloads a complete ThermoDataSet with getDatabase; the time of the whole request and the time
+spent reading the query result into the ThermoDataSet (from the end of the Fetch stage to the end of the Parse
+stage) are measured, against a local ArangoDB holding a copy of the ThermoHub data, or tools/standin_server.py
+serving database files (the server is given by a connection configuration file), e.g.
+
+    python tools/standin_server.py aq17.json --config local-hub-config.json &
+
+    python tools/benchmark_velocypack.py local-hub-config.json aq17 --repeat 5
+"""
+
+import argparse
+import os
+import statistics
+import time
+
+import thermohubclient as client
+
+
+def time_requests(dbc, thermodataset, repeat):
+    totals = []
+    parsing = []
+    for _ in range(repeat):
+        # time of the last report of each stage
+        stages = {}
+        dbc.setProgressCallback(lambda p: stages.__setitem__(p.stage, (time.perf_counter(), p.bytesReceived)))
+        start = time.perf_counter()
+        dbc.getDatabase(thermodataset)
+        totals.append(time.perf_counter() - start)
+        parsing.append(stages[client.RequestStage.Parse][0] - stages[client.RequestStage.Fetch][0])
+    return statistics.median(totals), statistics.median(parsing), stages[client.RequestStage.Fetch][1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("config", help="connection configuration file of the server")
+    parser.add_argument("thermodatasets", nargs="+", help="symbols of the ThermoDataSets to query")
+    parser.add_argument("--repeat", type=int, default=3, help="requests per transport (the median times are reported)")
+    args = parser.parse_args()
+
+    dbc = client.DatabaseClient(os.path.abspath(args.config))
+    for thermodataset in args.thermodatasets:
+        print(thermodataset)
+        print(f"  {'transport':>10}  {'bytes':>11}  {'seconds':>9}  {'parse s':>9}")
+        for velocypack in [False, True]:
+            options = client.DatabaseClientOptions()
+            # each request queries the server, a cached ThermoDataSet would be timed instead
+            options.cacheThermoDataSets = False
+            options.velocypackTransport = velocypack
+            dbc.setOptions(options)
+            seconds, parse, received = time_requests(dbc, thermodataset, args.repeat)
+            print(f"  {'VelocyPack' if velocypack else 'JSON':>10}  {received:11d}  {seconds:9.3f}  {parse:9.3f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,60 @@
+"""Report the elements, substances and reactions added, removed and modified between two versions of a ThermoDataSet.
+
+Records are matched by symbol and compared by a hash of their content, so the order of the records
+and of their properties, null properties and the writing of numbers do not count as changes. The
+files (.json, .json.gz or .json.zst) are read one record at a time, e.g.
+
+    python tools/diff_thermodatasets.py aq17-pinned-thermofun.json aq17-thermofun.json.zst
+
+or the pinned export is compared with the ThermoDataSet on the server
+
+    python tools/diff_thermodatasets.py aq17-pinned-thermofun.json --thermodataset aq17 --config hub-connection-config.json
+"""
+
+import argparse
+import json
+import sys
+
+import thermohubclient as client
+
+RECORDS = ["elements", "substances", "reactions"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("before", help="database file of the old version")
+    parser.add_argument("after", nargs="?", help="database file of the new version")
+    parser.add_argument("--thermodataset", help="compare with this ThermoDataSet of the server instead of a file")
+    parser.add_argument("--config", help="connection configuration file of the server (the default remote server if not given)")
+    parser.add_argument("--json", action="store_true", help="print the changes as JSON")
+    args = parser.parse_args()
+
+    if (args.after is None) == (args.thermodataset is None):
+        parser.error("give either the new database file or --thermodataset")
+
+    if args.after is not None:
+        diff = client.diffDatabaseFiles(args.before, args.after)
+    else:
+        dbc = client.DatabaseClient(args.config) if args.config else client.DatabaseClient()
+        after = client.hashThermoDataSetText(dbc.getDatabaseResult(args.thermodataset))
+        diff = client.diffThermoDataSets(client.hashDatabaseFile(args.before), after)
+
+    if args.json:
+        json.dump(diff, sys.stdout, indent=2)
+        print()
+    else:
+        for name in RECORDS:
+            changes = diff[name]
+            print(f"{name}: {len(changes['added'])} added, {len(changes['removed'])} removed, {len(changes['modified'])} modified")
+            for change, sign in [("added", "+"), ("removed", "-"), ("modified", "~")]:
+                for symbol in changes[change]:
+                    print(f"  {sign} {symbol}")
+            for symbol in changes["duplicated"]:
+                print(f"  ! {symbol} (more than one record)")
+
+    # exit status 1 when the versions differ, as diff
+    return int(any(diff[name][change] for name in RECORDS for change in ("added", "removed", "modified")))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,372 @@
+"""Stand-in for the ThermoHub ArangoDB server, serving ThermoDataSets held in database files.
+
+It answers the AQL cursor requests of DatabaseClient over HTTP on localhost: the ThermoDataSet queries
+(selection by substance symbols, classes and aggregate states, returned properties, reactions defining
+the substances, records sorted and unique by symbol) and the lists of ThermoDataSets, elements,
+substances, reactions, substance classes and aggregate states. Answers are JSON, or VelocyPack when
+the request accepts application/x-velocypack. Delays, error answers and dropped connections can be
+injected into the ThermoDataSet queries, to exercise the deadlines, retries and hedging of
+DatabaseClientOptions.requestOptions.
+
+Run it with the connection configuration file to give to the benchmarks, e.g.
+
+    python tools/standin_server.py aq17-thermofun.json cemdata18-thermofun.json.gz --config local-hub-config.json --delay-ms 50
+
+or start it from a test:
+
+    server = StandInServer({"aq17": thermodataset})
+    server.start()
+    dbc = client.DatabaseClient(server.writeConfig(os.path.join(directory, "config.json")))
+    server.inject(code=503, errorNum=21)  # the next ThermoDataSet query is answered by an overload error
+"""
+
+import argparse
+import gzip
+import http.server
+import json
+import os
+import random
+import re
+import struct
+import threading
+import time
+
+DATABASE = "hub_main"
+
+ELEMENT_FIELDS = ["symbol", "class_", "entropy", "atomic_mass", "datasources"]
+
+
+class RawJson(str):
+    """Value written as the JSON text it holds, e.g. RawJson("1.50E+2") for a number written that way"""
+
+
+class Fault:
+    """Delay in seconds before the answer, then an error answer (HTTP code and ArangoDB errorNum), or the connection closed"""
+
+    def __init__(self, delay=0.0, code=0, errorNum=0, drop=False):
+        self.delay = delay
+        self.code = code
+        self.errorNum = errorNum
+        self.drop = drop
+
+
+def _to_json(value):
+    # RawJson values are written through markers; the server escapes forward slashes as ArangoDB does
+    text = json.dumps(value, ensure_ascii=False, separators=(",", ":")).replace("/", "\\/")
+    return re.sub(r'"\\u0001(.*?)\\u0001"', lambda m: m.group(1), text)
+
+
+def _mark_raw(value):
+    if isinstance(value, RawJson):
+        return "\x01" + value + "\x01"
+    if isinstance(value, dict):
+        return {key: _mark_raw(item) for key, item in value.items()}
+    if isinstance(value, list):
+        return [_mark_raw(item) for item in value]
+    return value
+
+
+def _vlq(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        out.append(byte | (0x80 if value else 0))
+        if not value:
+            return bytes(out)
+
+
+def _compact(head, payload, count):
+    # compact array or object: head, byte length, items, number of items (reversed)
+    tail = _vlq(count)[::-1]
+    for size in range(1, 10):
+        total = 1 + size + len(payload) + len(tail)
+        length = _vlq(total)
+        if len(length) == size:
+            return bytes([head]) + length + payload + tail
+    raise ValueError("VelocyPack value too large")
+
+
+def to_velocypack(value):
+    """VelocyPack encoding of a JSON value, with compact arrays and objects"""
+    if isinstance(value, RawJson):
+        value = json.loads(value)
+    if value is None:
+        return b"\x18"
+    if value is False:
+        return b"\x19"
+    if value is True:
+        return b"\x1a"
+    if isinstance(value, int) and not -2**63 <= value < 2**64:
+        # integers out of the 64-bit range are doubles in ArangoDB
+        value = float(value)
+    if isinstance(value, int):
+        if 0 <= value <= 9:
+            return bytes([0x30 + value])
+        if -6 <= value < 0:
+            return bytes([0x40 + value])
+        if value > 0:
+            size = (value.bit_length() + 7) // 8
+            return bytes([0x27 + size]) + value.to_bytes(size, "little")
+        size = ((-value - 1).bit_length() + 8) // 8
+        return bytes([0x1f + size]) + value.to_bytes(size, "little", signed=True)
+    if isinstance(value, float):
+        return b"\x1b" + struct.pack("<d", value)
+    if isinstance(value, str):
+        data = value.encode("utf-8")
+        if len(data) <= 126:
+            return bytes([0x40 + len(data)]) + data
+        return b"\xbf" + struct.pack("<Q", len(data)) + data
+    if isinstance(value, list):
+        if not value:
+            return b"\x01"
+        return _compact(0x13, b"".join(to_velocypack(item) for item in value), len(value))
+    if isinstance(value, dict):
+        if not value:
+            return b"\x0a"
+        payload = b"".join(to_velocypack(key) + to_velocypack(item) for key, item in value.items())
+        return _compact(0x14, payload, len(value))
+    raise TypeError(f"no VelocyPack encoding of {type(value).__name__}")
+
+
+def read_thermodataset(fileName):
+    """ThermoDataSet symbol and data of a .json or .json.gz database file"""
+    opener = gzip.open if fileName.endswith(".gz") else open
+    with opener(fileName, "rt", encoding="utf-8") as f:
+        data = json.load(f)
+    symbol = data.get("thermodataset")
+    if isinstance(symbol, list):
+        symbol = symbol[0] if symbol else None
+    if not symbol:
+        symbol = os.path.basename(fileName).split("-")[0].split(".")[0]
+    return symbol, data
+
+
+class StandInServer:
+    """Stand-in ArangoDB answering the queries of DatabaseClient for the ThermoDataSets given by symbol"""
+
+    def __init__(self, thermodatasets, port=0):
+        self.thermodatasets = thermodatasets
+        # delay of every ThermoDataSet query in seconds, with a random extra delay up to jitter
+        self.delay = 0.0
+        self.jitter = 0.0
+        self.faults = []
+        # ThermoDataSet queries received, and the Accept header of each
+        self.queries = 0
+        self.accepted = []
+        self._lock = threading.Lock()
+        server = self
+
+        class Handler(http.server.BaseHTTPRequestHandler):
+            protocol_version = "HTTP/1.1"
+
+            def log_message(self, *args):
+                pass
+
+            def do_GET(self):
+                server._generic(self)
+
+            def do_DELETE(self):
+                server._generic(self)
+
+            def do_PUT(self):
+                self._body()
+                if "/_api/cursor/" in self.path:
+                    return server._answer(self, 404, {"error": True, "code": 404, "errorNum": 1600, "errorMessage": "cursor not found"})
+                server._generic(self)
+
+            def do_POST(self):
+                body = self._body()
+                if self.path.endswith("/_api/cursor"):
+                    return server._cursor(self, body)
+                server._generic(self)
+
+            def _body(self):
+                length = int(self.headers.get("Content-Length", 0))
+                return self.rfile.read(length) if length else b""
+
+        self._httpd = http.server.ThreadingHTTPServer(("127.0.0.1", port), Handler)
+        self._httpd.daemon_threads = True
+        self._thread = None
+
+    @property
+    def port(self):
+        return self._httpd.server_address[1]
+
+    @property
+    def url(self):
+        return f"http://127.0.0.1:{self.port}"
+
+    def start(self):
+        self._thread = threading.Thread(target=self._httpd.serve_forever, daemon=True)
+        self._thread.start()
+        return self
+
+    def stop(self):
+        self._httpd.shutdown()
+        self._httpd.server_close()
+        if self._thread:
+            self._thread.join()
+
+    def inject(self, delay=0.0, code=0, errorNum=0, drop=False):
+        """Answer the next ThermoDataSet query after the delay with an error, or close its connection (faults are used in turn)"""
+        with self._lock:
+            self.faults.append(Fault(delay, code, errorNum, drop))
+
+    def writeConfig(self, fileName):
+        """Write the connection configuration file of DatabaseClient for this server, and return its name"""
+        local = {
+            "DBName": DATABASE, "DBCreate": False, "DB_URL": self.url, "DBUser": "root", "DBUserPassword": "",
+            "DBAccess": "ro", "DBRootName": "_system", "DBRootUser": "root", "DBRootPassword": "",
+        }
+        config = {"arangodb": {"UseArangoDBInstance": "ArangoDBLocal", "UseVelocypackPut": False,
+                               "UseVelocypackGet": False, "ArangoDBLocal": local, "ArangoDBRemote": local}}
+        with open(fileName, "w") as f:
+            json.dump(config, f, indent=2)
+        return fileName
+
+    def _answer(self, handler, code, document):
+        velocypack = "application/x-velocypack" in handler.headers.get("Accept", "")
+        body = to_velocypack(document) if velocypack else _to_json(_mark_raw(document)).encode("utf-8")
+        try:
+            handler.send_response(code)
+            handler.send_header("Content-Type", "application/x-velocypack" if velocypack else "application/json; charset=utf-8")
+            handler.send_header("Content-Length", str(len(body)))
+            handler.end_headers()
+            handler.wfile.write(body)
+        except (BrokenPipeError, ConnectionResetError):
+            pass  # the client gave up on the request (timeout or cancellation)
+
+    def _generic(self, handler):
+        # version, database, collection and user requests made when connecting
+        self._answer(handler, 200, {
+            "error": False, "code": 200, "server": "arango", "version": "3.7.0", "license": "community",
+            "name": "thermodatasets", "type": 2, "status": 3, "id": "1", "isSystem": False,
+            "result": {"name": DATABASE, "id": "1", "path": "", "isSystem": False},
+        })
+
+    def _error(self, handler, code, errorNum, message):
+        self._answer(handler, code, {"error": True, "code": code, "errorNum": errorNum, "errorMessage": message})
+
+    def _cursor(self, handler, body):
+        try:
+            request = json.loads(body)
+            query = request["query"]
+            bind = request.get("bindVars") or {}
+            if isinstance(bind, str):
+                bind = json.loads(bind)
+        except (ValueError, KeyError):
+            return self._error(handler, 400, 600, "invalid cursor request")
+
+        if "LET tds" in query:
+            with self._lock:
+                self.queries += 1
+                self.accepted.append(handler.headers.get("Accept", ""))
+                fault = self.faults.pop(0) if self.faults else Fault()
+            delay = fault.delay + self.delay + random.uniform(0, self.jitter)
+            if delay > 0:
+                time.sleep(delay)
+            if fault.drop:
+                handler.close_connection = True
+                return
+            if fault.code:
+                return self._error(handler, fault.code, fault.errorNum, "injected error")
+            symbol = bind.get("idThermoDataSet", "").split("/")[-1]
+            if symbol not in self.thermodatasets:
+                return self._error(handler, 404, 1202, "document not found")
+            result = [self._thermodataset(symbol, query, bind)]
+        else:
+            result = self._list(query)
+            if result is None:
+                return self._error(handler, 400, 1501, "syntax error, unexpected query")
+        self._answer(handler, 201, {"result": result, "hasMore": False, "cached": False, "error": False, "code": 201})
+
+    def _list(self, query):
+        match = re.search(r'u\.properties\.symbol == "(.*?)"', query)
+        data = self.thermodatasets.get(match.group(1), {}) if match else {}
+        symbols = lambda name: sorted({record.get("symbol") for record in data.get(name, [])})
+        if "RETURN u._id" in query:
+            return [f"thermodatasets/{match.group(1)}"] if match and match.group(1) in self.thermodatasets else []
+        if "INBOUND u basis" in query:
+            return symbols("elements")
+        if "OUTBOUND s takes" in query:
+            return symbols("reactions")
+        for prop in ["class_", "aggregate_state"]:
+            if f"RETURN DISTINCT s.properties.{prop}" in query:
+                values = []
+                for substance in data.get("substances", []):
+                    if substance.get(prop) not in values:
+                        values.append(substance.get(prop))
+                return values
+        if "INBOUND u pulls" in query:
+            return symbols("substances")
+        if "RETURN u.properties.symbol" in query:
+            return list(self.thermodatasets)
+        return None
+
+    @staticmethod
+    def _defining(substance):
+        if "defining_reactions" in substance:
+            return list(substance["defining_reactions"])
+        return [substance["reaction"]] if substance.get("reaction") else []
+
+    def _thermodataset(self, symbol, query, bind):
+        data = self.thermodatasets[symbol]
+        fields = re.search(r"RETURN \{ ((?:(?!RETURN).)*?) \} \n\s*\) \n\s*RETURN \{ substance : \{ (.*) \}, reactions : reactions_ \}", query, re.S)
+        reactionFields = re.findall(r"(\w+): ", fields.group(1))
+        substanceFields = re.findall(r"(\w+): ", fields.group(2))
+        reactions = {reaction.get("symbol"): reaction for reaction in data.get("reactions", [])}
+
+        def selected(substance, name, key):
+            return name not in bind or json.dumps(substance.get(key), sort_keys=True) in \
+                [json.dumps(value, sort_keys=True) for value in bind[name]]
+
+        substances, selectedReactions = {}, {}
+        for substance in data.get("substances", []):
+            if not ("symbolList" not in bind or substance.get("symbol") in bind["symbolList"]) or \
+                    not selected(substance, "class_List", "class_") or not selected(substance, "aggregate_stateList", "aggregate_state"):
+                continue
+            defining = [name for name in self._defining(substance) if name in reactions]
+            record = {}
+            for name in substanceFields:
+                if name == "defining_reactions":
+                    record[name] = defining
+                elif name == "reaction":
+                    record[name] = substance.get("reaction", defining[0] if defining else None)
+                else:
+                    record[name] = substance.get(name)
+            substances.setdefault(record["symbol"], record)
+            for name in defining:
+                selectedReactions.setdefault(name, {field: reactions[name].get(field) for field in reactionFields})
+
+        elements = {}
+        for element in data.get("elements", []):
+            elements.setdefault(element.get("symbol"), {name: element.get(name) for name in ELEMENT_FIELDS})
+        ordered = lambda records: [records[key] for key in sorted(records)]
+        return {"thermodataset": [symbol], "datasources": ["db.thermohub.org"], "date": "01.01.2020 00:00:00",
+                "substances": ordered(substances), "reactions": ordered(selectedReactions), "elements": ordered(elements)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("files", nargs="+", help="database files (.json or .json.gz) of the ThermoDataSets to serve")
+    parser.add_argument("--port", type=int, default=0, help="port to listen on (a free one by default)")
+    parser.add_argument("--config", help="write the connection configuration file of DatabaseClient for this server")
+    parser.add_argument("--delay-ms", type=float, default=0, help="delay of every ThermoDataSet query in milliseconds")
+    parser.add_argument("--jitter-ms", type=float, default=0, help="random extra delay of the ThermoDataSet queries up to this value")
+    args = parser.parse_args()
+
+    server = StandInServer(dict(read_thermodataset(fileName) for fileName in args.files), args.port)
+    server.delay = args.delay_ms / 1000
+    server.jitter = args.jitter_ms / 1000
+    if args.config:
+        server.writeConfig(args.config)
+    print(f"serving {', '.join(server.thermodatasets)} on {server.url}")
+    try:
+        server._httpd.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
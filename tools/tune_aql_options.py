@@ -0,0 +1,58 @@
+"""Sweep the AQL execution options of the ThermoDataSet queries and report the fastest settings.
+
+Run against a local ArangoDB holding a copy of the ThermoHub data (the stand-in server is
+given by a connection configuration file), e.g.
+
+    python tools/tune_aql_options.py local-hub-config.json aq17 mines16 --repeat 5
+"""
+
+import argparse
+import itertools
+import statistics
+import time
+
+import thermohubclient as client
+
+OPTIMIZER_RULES = {
+    "default": [],
+    "-all,+remove-unnecessary-filters": ["-all", "+remove-unnecessary-filters"],
+    "-all": ["-all"],
+}
+
+
+def time_query(dbc, thermodataset, repeat):
+    times = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        dbc.getDatabaseResult(thermodataset)
+        times.append(time.perf_counter() - start)
+    return statistics.median(times)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("config", help="connection configuration file of the stand-in server")
+    parser.add_argument("thermodatasets", nargs="+", help="symbols of the ThermoDataSets to query")
+    parser.add_argument("--repeat", type=int, default=3, help="queries per setting (the median time is reported)")
+    args = parser.parse_args()
+
+    dbc = client.DatabaseClient(args.config)
+    for thermodataset in args.thermodatasets:
+        results = []
+        for max_plans, rules, stream in itertools.product([0, 1], OPTIMIZER_RULES, [False, True]):
+            options = client.DatabaseClientOptions()
+            options.aqlOptions.maxPlans = max_plans
+            options.aqlOptions.optimizerRules = OPTIMIZER_RULES[rules]
+            options.aqlOptions.stream = stream
+            dbc.setOptions(options)
+            results.append((time_query(dbc, thermodataset, args.repeat), max_plans, rules, stream))
+
+        size = len(dbc.getDatabaseResult(thermodataset))
+        print(f"{thermodataset} ({size} bytes)")
+        print(f"  {'seconds':>9}  {'maxPlans':>8}  {'stream':>6}  optimizerRules")
+        for seconds, max_plans, rules, stream in sorted(results):
+            print(f"  {seconds:9.3f}  {max_plans:8d}  {str(stream):>6}  {rules}")
+
+
+if __name__ == "__main__":
+    main()